@@ -4,6 +4,11 @@ Simple example of A* search
 A* is similar to a uniform cost search with the only difference
 that we have a cost function g and a heurisitc function h which
 define the total cost function f = g + h
+
+AStar is templated on the weight type W (see weights.h): AStar<> uses
+int, AStar<int64_t> avoids overflow on long routes, AStar<double> and
+AStar<Fixed<100>> take fractional distances. The heuristic must return
+a value W can be constructed from, e.g. an int or a double for Fixed.
 */
 
 #include <vector>
@@ -12,51 +17,63 @@ define the total cost function f = g + h
 #include <iostream>
 #include <limits.h>
 
+#include "compressed_graph.h"
+#include "weights.h"
+#include "components.h"
+
 using namespace std;
 
+template <typename W = int>
 struct Node
 {
     int id;
     Node *next;
-    int f;
-    int g;
+    W f;
+    W g;
 };
 
+template <typename W = int>
 class AStar
 {
 private:
-    int heuristic(int neigh_idx, int T)
-    {
-    }
+    typedef WeightTraits<W> Traits;
+    typedef pair<W, int> Entry; // (f, node_idx)
 
 public:
     // In this implementation, we define the edge as (neigh_idx, g, h)
-    template <typename Heuristic>
-    Node *findPath(vector<vector<pair<int, int>>> &adj, int S, int T, Heuristic h)
+    // Graph is vector<vector<pair<int, W>>> or anything shaped like it,
+    // such as CompressedWeightedGraph. If a ComponentIndex (built with
+    // ComponentIndex::FirstTarget) is given, targets in another component
+    // are rejected before searching
+    template <typename Graph, typename Heuristic>
+    Node<W> *findPath(const Graph &adj, int S, int T, Heuristic h, const ComponentIndex *components = nullptr)
     {
         if (S == T)
         {
-            Node *head = new Node{S, nullptr, 0};
+            Node<W> *head = new Node<W>{S, nullptr, Traits::zero(), Traits::zero()};
             return head;
         }
 
+        if (components != nullptr && !components->mayReach(S, T))
+            return nullptr; // different components, nothing to explore
+
         int n = adj.size();
         vector<bool> visited(n, 0);
         vector<int> parents(n, -1);
 
-        vector<int> f(n, INT_MAX);
-        vector<int> g(n, INT_MAX);
-        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq; // by default it's ordered by first
+        vector<W> f(n, Traits::infinity());
+        vector<W> g(n, Traits::infinity());
+        priority_queue<Entry, vector<Entry>, greater<Entry>> pq; // by default it's ordered by first
 
-        pq.push(make_pair(0, S));
-        g[S] = 0;
-        f[S] = g[S] + h(S, T);
+        pq.push(make_pair(Traits::zero(), S));
+        g[S] = Traits::zero();
+        f[S] = Traits::add(g[S], W(h(S, T)));
 
         while (!pq.empty())
         {
-            pair<int, int> curr = pq.top();
+            Entry curr = pq.top();
 
-            int node_cost = curr.first;
+            W node_cost = curr.first;
             int node_idx = curr.second;
 
             pq.pop();
@@ -71,20 +88,21 @@ public:
                 break;
             }
 
-            for (size_t i = 0; i < adj[node_idx].size(); ++i)
+            for (pair<int, W> edge : adj[node_idx])
             {
-                int neigh_idx = adj[node_idx][i].first;
-                int neigh_g = adj[node_idx][i].second;
+                int neigh_idx = edge.first;
+                W neigh_g = edge.second;
 
                 if (!visited[neigh_idx])
                 {
-                    if (g[neigh_idx] > g[node_idx] + neigh_g)
+                    W newG = Traits::add(g[node_idx], neigh_g);
+                    if (g[neigh_idx] > newG)
                     {
                         // update with the lower cost path
                         parents[neigh_idx] = node_idx;
-                        g[neigh_idx] = g[node_idx] + neigh_g;
-                        f[neigh_idx] = g[neigh_idx] + h(neigh_idx, T);
-                        pair<int, int> newNeigh{f[neigh_idx], neigh_idx};
+                        g[neigh_idx] = newG;
+                        f[neigh_idx] = Traits::add(g[neigh_idx], W(h(neigh_idx, T)));
+                        Entry newNeigh{f[neigh_idx], neigh_idx};
                         pq.push(newNeigh);
                     }
                 }
@@ -95,17 +113,17 @@ public:
             return nullptr;
 
         int curr = T;
-        Node *head = new Node{curr, nullptr};
+        Node<W> *head = new Node<W>{curr, nullptr, f[curr], g[curr]};
         while (curr != S)
         {
             curr = parents[curr];
-            Node *parentNode = new Node{curr, head, f[curr], g[curr]};
+            Node<W> *parentNode = new Node<W>{curr, head, f[curr], g[curr]};
             head = parentNode;
         }
         return head;
     }
 
-    void printPath(Node *head)
+    void printPath(Node<W> *head)
     {
         if (head == nullptr)
             return;
@@ -118,15 +136,15 @@ public:
         cout << head->id << ", " << head->g << endl;
     }
 
-    void deletePath(Node *head)
+    void deletePath(Node<W> *head)
     {
         if (head == nullptr)
             return;
 
-        Node *curr = head;
+        Node<W> *curr = head;
         while (curr->next != nullptr)
         {
-            Node *nextNode = curr->next;
+            Node<W> *nextNode = curr->next;
             delete curr;
             curr = nextNode;
         }
@@ -172,7 +190,7 @@ int main()
     adj[2] = {{0, 1}, {3, 1}};
     adj[3] = {{1, 1}, {2, 1}};
 
-    AStar solver;
+    AStar<> solver;
 
     // Definiamo l'euristica di Manhattan: |x1 - x2| + |y1 - y2|
     auto manhattan = [&coords](int i, int j)
@@ -180,10 +198,10 @@ int main()
         return abs(coords[i].x - coords[j].x) + abs(coords[i].y - coords[j].y);
     };
 
-    Node *path = solver.findPath(adj, 0, 3, manhattan);
+    Node<> *path = solver.findPath(adj, 0, 3, manhattan);
 
     // Stampa del percorso
-    Node *curr = path;
+    Node<> *curr = path;
     cout << "Found path " << endl;
     while (curr)
     {
@@ -193,5 +211,26 @@ int main()
 
     solver.deletePath(path);
 
+    // same search over the delta + varint encoded lists
+    CompressedWeightedGraph packed(adj);
+    path = solver.findPath(packed, 0, 3, manhattan);
+    solver.printPath(path);
+    solver.deletePath(path);
+
+    // fractional distances in miles, kept exact to 1/100 of a mile
+    typedef Fixed<100> Miles;
+    vector<vector<pair<int, Miles>>> roads(4);
+    roads[0] = {{1, Miles::fromDouble(1.25)}, {2, Miles::fromDouble(1.5)}};
+    roads[1] = {{0, Miles::fromDouble(1.25)}, {3, Miles::fromDouble(1.0)}};
+    roads[2] = {{0, Miles::fromDouble(1.5)}, {3, Miles::fromDouble(1.75)}};
+    roads[3] = {{1, Miles::fromDouble(1.0)}, {2, Miles::fromDouble(1.75)}};
+
+    // no road is shorter than its grid step, so the integer manhattan
+    // distance stays admissible; Miles is built from its int result
+    AStar<Miles> milesSolver;
+    Node<Miles> *route = milesSolver.findPath(roads, 0, 3, manhattan);
+    milesSolver.printPath(route);
+    milesSolver.deletePath(route);
+
     return 0;
 }
\ No newline at end of file
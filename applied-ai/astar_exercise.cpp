@@ -4,14 +4,22 @@ Simple example of A* search
 A* is similar to a uniform cost search with the only difference
 that we have a cost function g and a heurisitc function h which
 define the total cost function f = g + h
+
+The heuristic is read by reference through h[node]: a vector<int> of
+estimates, or an exact DistanceTable from HeuristicStore (see
+heuristic_store.h). Ties on f go to the node with the larger g, so with
+an exact table only the nodes of an optimal path are expanded.
 */
 
 #include <vector>
 #include <utility>
 #include <queue>
+#include <tuple>
 #include <iostream>
 #include <limits.h>
 
+#include "heuristic_store.h"
+
 using namespace std;
 
 struct Node
@@ -27,13 +35,14 @@ class AStar
 
 public:
     // In this implementation, we define the edge as (neigh_idx, g, h)
-    Node *findPath(vector<vector<pair<int, int>>> &adj, int S, int T, vector<int> h,
+    template <typename Heuristic>
+    Node *findPath(vector<vector<pair<int, int>>> &adj, int S, int T, const Heuristic &h,
                    vector<int> &expansion_log)
     {
         expansion_log.clear(); // Puliamo il log all'inizio
         if (S == T)
         {
-            Node *head = new Node{S, nullptr, 0};
+            Node *head = new Node{S, nullptr, 0, 0};
             return head;
         }
 
@@ -43,18 +52,19 @@ public:
 
         vector<int> f(n, INT_MAX);
         vector<int> g(n, INT_MAX);
-        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq; // by default it's ordered by first
+        typedef tuple<int, int, int> Entry;                         // (f, -g, node_idx)
+        priority_queue<Entry, vector<Entry>, greater<Entry>> pq; // by default it's ordered by first
 
-        pq.push(make_pair(0, S));
+        pq.push(make_tuple(0, 0, S));
         g[S] = 0;
         f[S] = g[S] + h[S];
 
         while (!pq.empty())
         {
-            pair<int, int> curr = pq.top();
+            Entry curr = pq.top();
 
-            int node_cost = curr.first;
-            int node_idx = curr.second;
+            int node_cost = get<0>(curr);
+            int node_idx = get<2>(curr);
 
             pq.pop();
             if (visited[node_idx])
@@ -75,6 +85,9 @@ public:
                 int neigh_idx = adj[node_idx][i].first;
                 int neigh_g = adj[node_idx][i].second;
 
+                if (h[neigh_idx] == INT_MAX)
+                    continue; // exact tables mark nodes that cannot reach T
+
                 if (!visited[neigh_idx])
                 {
                     if (g[neigh_idx] > g[node_idx] + neigh_g)
@@ -83,8 +96,7 @@ public:
                         parents[neigh_idx] = node_idx;
                         g[neigh_idx] = g[node_idx] + neigh_g;
                         f[neigh_idx] = g[neigh_idx] + h[neigh_idx];
-                        pair<int, int> newNeigh{f[neigh_idx], neigh_idx};
-                        pq.push(newNeigh);
+                        pq.push(make_tuple(f[neigh_idx], -g[neigh_idx], neigh_idx));
                     }
                 }
             }
@@ -94,7 +106,7 @@ public:
             return nullptr;
 
         int curr = T;
-        Node *head = new Node{curr, nullptr};
+        Node *head = new Node{curr, nullptr, f[curr], g[curr]};
         while (curr != S)
         {
             curr = parents[curr];
@@ -204,5 +216,21 @@ int main()
 
     solver.deletePath(path);
 
+    // exact heuristic for a hot destination: the second query for K
+    // builds the table, later ones reuse it
+    HeuristicStore store(graph, 1 << 20);
+    for (char start : {'A', 'B', 'G'})
+    {
+        shared_ptr<const DistanceTable> exact = store.lookup(c_to_i('K'));
+        if (exact == nullptr)
+            path = solver.findPath(graph, c_to_i(start), c_to_i('K'), h_vals, expansion_log);
+        else
+            path = solver.findPath(graph, c_to_i(start), c_to_i('K'), *exact, expansion_log);
+
+        cout << (exact ? "Exact h, " : "Estimated h, ") << expansion_log.size() << " expansions: ";
+        printPathConLettere(path);
+        solver.deletePath(path);
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -6,6 +6,9 @@ Simple example of Breadth First Search
 #include <queue>
 #include <iostream>
 
+#include "compressed_graph.h"
+#include "components.h"
+
 using namespace std;
 
 struct Node
@@ -17,7 +20,11 @@ struct Node
 class BFS
 {
 public:
-    Node *findPath(vector<vector<int>> &adj, int S, int T)
+    // Graph is vector<vector<int>> or anything shaped like it, such as
+    // CompressedGraph. If a ComponentIndex is given, targets in another
+    // component are rejected before searching
+    template <typename Graph>
+    Node *findPath(const Graph &adj, int S, int T, const ComponentIndex *components = nullptr)
     {
         if (S == T)
         {
@@ -25,6 +32,9 @@ public:
             return head;
         }
 
+        if (components != nullptr && !components->mayReach(S, T))
+            return nullptr; // different components, nothing to explore
+
         queue<int> q;
         int n = adj.size();
         vector<bool> visited(n, 0);
@@ -40,9 +50,8 @@ public:
             int U = q.front();
             q.pop();
 
-            for (size_t i = 0; i < adj[U].size(); ++i)
+            for (int N : adj[U])
             {
-                int N = adj[U][i];
                 if (!visited[N])
                 {
                     visited[N] = true;
@@ -115,4 +124,43 @@ int main()
     Node *head = bfs.findPath(adj, 0, 3);
     bfs.printPath(head);
     bfs.deletePath(head);
+
+    // same search over the delta + varint encoded lists
+    CompressedGraph packed(adj);
+    head = bfs.findPath(packed, 0, 3);
+    bfs.printPath(head);
+    bfs.deletePath(head);
+
+    // 3 cannot reach 0: the component index answers without searching
+    ComponentIndex components;
+    components.build(adj, true);
+    head = bfs.findPath(adj, 3, 0, &components);
+    cout << (head ? "Path found" : "No path from 3 to 0") << endl;
+
+    // memory of a 1000x1000 grid in both representations
+    int side = 1000;
+    vector<vector<int>> grid(side * side);
+    for (int u = 0; u < side * side; ++u)
+    {
+        int x = u % side;
+        int y = u / side;
+        if (x > 0)
+            grid[u].push_back(u - 1);
+        if (x + 1 < side)
+            grid[u].push_back(u + 1);
+        if (y > 0)
+            grid[u].push_back(u - side);
+        if (y + 1 < side)
+            grid[u].push_back(u + side);
+    }
+    CompressedGraph packedGrid(grid);
+    cout << "Grid adjacency: " << adjacencyBytes(grid) / (1024 * 1024) << " MB as vector<vector<int>>, "
+         << packedGrid.memoryBytes() / (1024 * 1024) << " MB compressed" << endl;
+
+    head = bfs.findPath(packedGrid, 0, side * side - 1);
+    int length = 0;
+    for (Node *curr = head; curr && curr->next; curr = curr->next)
+        length++;
+    cout << "Compressed grid path length: " << length << endl;
+    bfs.deletePath(head);
 }
\ No newline at end of file
@@ -0,0 +1,239 @@
+/*
+Connected-component index for instant "no route" answers
+
+Built once per graph, then every search checks mayReach(S, T) before
+exploring anything: if it is false the target is certainly unreachable
+and the search returns nullptr in O(1).
+
+  - undirected graphs: connected components with a lock-free union-find,
+    the edges are split across threads and joined with CAS on the parent
+    array. mayReach is exact.
+  - directed graphs: weakly connected components (same union-find) plus
+    strongly connected components (iterative Tarjan). Tarjan numbers the
+    SCCs in reverse topological order, so S can only reach T if
+    scc(S) >= scc(T). This is a necessary condition, not a sufficient
+    one: mayReach never rejects a reachable target, but may let some
+    unreachable ones through to the search.
+
+The graph is read through a target(edge) accessor so every adjacency
+layout in the repo works: plain ints (BFS/DFS), (neigh_idx, cost) for
+AStar and (cost, neigh_idx) for UCS. Rebuild the index if the graph
+changes.
+*/
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <utility>
+
+class ComponentIndex
+{
+public:
+    // neighbour id of an edge in each adjacency layout
+    struct PlainTarget
+    {
+        int operator()(int v) const { return v; }
+    };
+
+    struct FirstTarget
+    {
+        template <typename E>
+        int operator()(const E &e) const { return e.first; }
+    };
+
+    struct SecondTarget
+    {
+        template <typename E>
+        int operator()(const E &e) const { return e.second; }
+    };
+
+    template <typename Graph, typename Target = PlainTarget>
+    void build(const Graph &adj, bool directed, Target target = Target(),
+               int numThreads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        isDirected = directed;
+
+        unionFind(adj, target, numThreads);
+        if (directed)
+            tarjan(adj, target);
+        else
+            scc.clear();
+    }
+
+    // false: T is certainly unreachable from S
+    bool mayReach(int S, int T) const
+    {
+        if (weak[S] != weak[T])
+            return false;
+        if (!isDirected)
+            return true;
+        return scc[S] >= scc[T];
+    }
+
+    int component(int v) const
+    {
+        return weak[v];
+    }
+
+    int numComponents() const
+    {
+        return numWeak;
+    }
+
+private:
+    bool isDirected = false;
+    int numWeak = 0;
+    std::vector<int> weak; // dense connected (weak) component id
+    std::vector<int> scc;  // Tarjan SCC id, reverse topological order
+
+    static int findRoot(std::vector<std::atomic<int>> &parent, int v)
+    {
+        while (true)
+        {
+            int p = parent[v].load(std::memory_order_relaxed);
+            if (p == v)
+                return v;
+            int gp = parent[p].load(std::memory_order_relaxed);
+            if (gp != p)
+                parent[v].compare_exchange_weak(p, gp, std::memory_order_relaxed); // path halving
+            v = gp;
+        }
+    }
+
+    static void unite(std::vector<std::atomic<int>> &parent, int a, int b)
+    {
+        while (true)
+        {
+            a = findRoot(parent, a);
+            b = findRoot(parent, b);
+            if (a == b)
+                return;
+            // always hang the larger root under the smaller one, so two
+            // threads can never link roots into a cycle
+            if (a < b)
+                std::swap(a, b);
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel))
+                return;
+        }
+    }
+
+    template <typename Graph, typename Target>
+    void unionFind(const Graph &adj, Target target, int numThreads)
+    {
+        int n = adj.size();
+        std::vector<std::atomic<int>> parent(n);
+        for (int v = 0; v < n; ++v)
+            parent[v].store(v, std::memory_order_relaxed);
+
+        auto runParallel = [&](auto body)
+        {
+            std::vector<std::thread> workers;
+            int chunk = (n + numThreads - 1) / numThreads;
+            for (int t = 0; t < numThreads; ++t)
+            {
+                int begin = t * chunk;
+                int end = std::min(n, begin + chunk);
+                if (begin < end)
+                    workers.emplace_back(body, begin, end);
+            }
+            for (std::thread &w : workers)
+                w.join();
+        };
+
+        runParallel([&](int begin, int end)
+                    {
+                        for (int u = begin; u < end; ++u)
+                        {
+                            for (const auto &edge : adj[u])
+                                unite(parent, u, target(edge));
+                        } });
+
+        // roots become dense ids in increasing order of the root
+        weak.assign(n, 0);
+        std::vector<int> rootId(n, -1);
+        numWeak = 0;
+        for (int v = 0; v < n; ++v)
+        {
+            if (findRoot(parent, v) == v)
+                rootId[v] = numWeak++;
+        }
+        runParallel([&](int begin, int end)
+                    {
+                        for (int v = begin; v < end; ++v)
+                            weak[v] = rootId[findRoot(parent, v)]; });
+    }
+
+    // iterative Tarjan, so deep graphs do not overflow the call stack
+    template <typename Graph, typename Target>
+    void tarjan(const Graph &adj, Target target)
+    {
+        int n = adj.size();
+        scc.assign(n, -1);
+        std::vector<int> index(n, -1), low(n, 0);
+        std::vector<char> onStack(n, 0);
+        std::vector<int> stack;
+        std::vector<std::pair<int, std::vector<int>>> frames; // (node, unvisited neighbours)
+        int counter = 0;
+        int numScc = 0;
+
+        for (int root = 0; root < n; ++root)
+        {
+            if (index[root] != -1)
+                continue;
+
+            auto open = [&](int v)
+            {
+                index[v] = low[v] = counter++;
+                stack.push_back(v);
+                onStack[v] = 1;
+                std::vector<int> neighs;
+                for (const auto &edge : adj[v])
+                    neighs.push_back(target(edge));
+                std::reverse(neighs.begin(), neighs.end());
+                frames.push_back({v, std::move(neighs)});
+            };
+            open(root);
+
+            while (!frames.empty())
+            {
+                int v = frames.back().first;
+                std::vector<int> &neighs = frames.back().second;
+
+                if (!neighs.empty())
+                {
+                    int w = neighs.back();
+                    neighs.pop_back();
+                    if (index[w] == -1)
+                        open(w); // invalidates neighs, re-read on the next turn
+                    else if (onStack[w])
+                        low[v] = std::min(low[v], index[w]);
+                    continue;
+                }
+
+                if (low[v] == index[v])
+                {
+                    int w;
+                    do
+                    {
+                        w = stack.back();
+                        stack.pop_back();
+                        onStack[w] = 0;
+                        scc[w] = numScc;
+                    } while (w != v);
+                    numScc++;
+                }
+
+                frames.pop_back();
+                if (!frames.empty())
+                {
+                    int parent = frames.back().first;
+                    low[parent] = std::min(low[parent], low[v]);
+                }
+            }
+        }
+    }
+};
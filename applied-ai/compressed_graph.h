@@ -0,0 +1,404 @@
+/*
+Compressed adjacency lists with delta + varint encoding
+
+Each neighbour list is sorted and stored as the gaps between consecutive
+neighbours, written as variable-length integers (7 bits per byte, the top
+bit says that another byte follows). The first neighbour is stored
+relative to the node itself (zig-zag encoded, so it can be negative), so
+local graphs such as grids and road networks mostly need one byte per
+edge instead of four, and there is no per-list heap allocation.
+
+The lists are decoded on the fly while iterating, and the classes expose
+the same shape as vector<vector<...>>: size(), adj[u].size() and range-for
+over adj[u]. This lets BFS, DFS, UCS and AStar (templated on the graph
+type) run on them unchanged.
+
+Note that neighbours come back in increasing order, which may change the
+order in which ties are explored compared to the original lists.
+*/
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+namespace compressed
+{
+    inline void putVarint(std::vector<uint8_t> &out, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    inline uint32_t getVarint(const uint8_t *&p)
+    {
+        uint32_t value = *p & 0x7f;
+        int shift = 7;
+        while (*p++ & 0x80)
+        {
+            value |= (uint32_t)(*p & 0x7f) << shift;
+            shift += 7;
+        }
+        return value;
+    }
+
+    inline uint32_t zigzag(int32_t value)
+    {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    inline int32_t unzigzag(uint32_t value)
+    {
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+
+    // byte offset of every list: a 64-bit base per block of 1024 lists
+    // plus a 32-bit offset inside the block, i.e. ~4 bytes per node
+    class OffsetIndex
+    {
+    private:
+        static const int BLOCK_BITS = 10;
+        std::vector<uint64_t> bases;
+        std::vector<uint32_t> offsets;
+
+    public:
+        void push(uint64_t offset)
+        {
+            if ((offsets.size() & ((1 << BLOCK_BITS) - 1)) == 0)
+                bases.push_back(offset);
+            offsets.push_back((uint32_t)(offset - bases.back()));
+        }
+
+        uint64_t operator[](size_t i) const
+        {
+            return bases[i >> BLOCK_BITS] + offsets[i];
+        }
+
+        size_t size() const
+        {
+            return offsets.size();
+        }
+
+        void reserve(size_t n)
+        {
+            offsets.reserve(n);
+            bases.reserve((n >> BLOCK_BITS) + 1);
+        }
+
+        size_t memoryBytes() const
+        {
+            return offsets.capacity() * sizeof(uint32_t) + bases.capacity() * sizeof(uint64_t);
+        }
+    };
+}
+
+// unweighted graph, adj[u] iterates over int neighbours like vector<int>
+class CompressedGraph
+{
+public:
+    class iterator
+    {
+    private:
+        const uint8_t *p;
+        uint32_t remaining;
+        int curr;
+
+        void decode(bool first)
+        {
+            if (remaining == 0)
+                return;
+            if (first)
+                curr += compressed::unzigzag(compressed::getVarint(p));
+            else
+                curr += (int)compressed::getVarint(p);
+        }
+
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int *pointer;
+        typedef int reference;
+
+        iterator(const uint8_t *p, uint32_t remaining, int u) : p(p), remaining(remaining), curr(u)
+        {
+            decode(true);
+        }
+
+        int operator*() const
+        {
+            return curr;
+        }
+
+        iterator &operator++()
+        {
+            remaining--;
+            decode(false);
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+            return remaining == other.remaining;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+            return remaining != other.remaining;
+        }
+    };
+
+    class NeighbourRange
+    {
+    private:
+        const uint8_t *p;
+        uint32_t degree;
+        int u;
+
+    public:
+        NeighbourRange(const uint8_t *p, uint32_t degree, int u) : p(p), degree(degree), u(u) {}
+
+        iterator begin() const
+        {
+            return iterator(p, degree, u);
+        }
+
+        iterator end() const
+        {
+            return iterator(p, 0, u);
+        }
+
+        size_t size() const
+        {
+            return degree;
+        }
+
+        bool empty() const
+        {
+            return degree == 0;
+        }
+    };
+
+    CompressedGraph() = default;
+
+    explicit CompressedGraph(const std::vector<std::vector<int>> &adj)
+    {
+        offsets.reserve(adj.size() + 1);
+        std::vector<int> sorted;
+        for (size_t u = 0; u < adj.size(); ++u)
+        {
+            offsets.push(bytes.size());
+            sorted.assign(adj[u].begin(), adj[u].end());
+            std::sort(sorted.begin(), sorted.end());
+
+            compressed::putVarint(bytes, sorted.size());
+            int prev = (int)u;
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                if (i == 0)
+                    compressed::putVarint(bytes, compressed::zigzag(sorted[i] - prev));
+                else
+                    compressed::putVarint(bytes, sorted[i] - prev);
+                prev = sorted[i];
+            }
+        }
+        offsets.push(bytes.size());
+        bytes.shrink_to_fit();
+    }
+
+    size_t size() const
+    {
+        return offsets.size() == 0 ? 0 : offsets.size() - 1;
+    }
+
+    NeighbourRange operator[](int u) const
+    {
+        const uint8_t *p = bytes.data() + offsets[u];
+        uint32_t degree = compressed::getVarint(p);
+        return NeighbourRange(p, degree, u);
+    }
+
+    size_t memoryBytes() const
+    {
+        return bytes.capacity() + offsets.memoryBytes();
+    }
+
+private:
+    compressed::OffsetIndex offsets; // byte offset of each list, n + 1 entries
+    std::vector<uint8_t> bytes;
+};
+
+/*
+Weighted graph with non-negative integer weights. Each edge is stored as
+the neighbour gap followed by the weight. The pairs come back in the same
+order as the input lists: AStar uses (neighbour, cost), UCS uses
+(cost, neighbour), so pass weightFirst = true for UCS graphs.
+*/
+class CompressedWeightedGraph
+{
+public:
+    class iterator
+    {
+    private:
+        const uint8_t *p;
+        uint32_t remaining;
+        int curr;
+        int weight = 0;
+        bool weightFirst;
+
+        void decode(bool first)
+        {
+            if (remaining == 0)
+                return;
+            if (first)
+                curr += compressed::unzigzag(compressed::getVarint(p));
+            else
+                curr += (int)compressed::getVarint(p);
+            weight = (int)compressed::getVarint(p);
+        }
+
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef std::pair<int, int> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::pair<int, int> *pointer;
+        typedef std::pair<int, int> reference;
+
+        iterator(const uint8_t *p, uint32_t remaining, int u, bool weightFirst)
+            : p(p), remaining(remaining), curr(u), weightFirst(weightFirst)
+        {
+            decode(true);
+        }
+
+        std::pair<int, int> operator*() const
+        {
+            return weightFirst ? std::make_pair(weight, curr) : std::make_pair(curr, weight);
+        }
+
+        iterator &operator++()
+        {
+            remaining--;
+            decode(false);
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+            return remaining == other.remaining;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+            return remaining != other.remaining;
+        }
+    };
+
+    class NeighbourRange
+    {
+    private:
+        const uint8_t *p;
+        uint32_t degree;
+        int u;
+        bool weightFirst;
+
+    public:
+        NeighbourRange(const uint8_t *p, uint32_t degree, int u, bool weightFirst)
+            : p(p), degree(degree), u(u), weightFirst(weightFirst) {}
+
+        iterator begin() const
+        {
+            return iterator(p, degree, u, weightFirst);
+        }
+
+        iterator end() const
+        {
+            return iterator(p, 0, u, weightFirst);
+        }
+
+        size_t size() const
+        {
+            return degree;
+        }
+
+        bool empty() const
+        {
+            return degree == 0;
+        }
+    };
+
+    CompressedWeightedGraph() = default;
+
+    CompressedWeightedGraph(const std::vector<std::vector<std::pair<int, int>>> &adj, bool weightFirst = false)
+        : weightFirst(weightFirst)
+    {
+        offsets.reserve(adj.size() + 1);
+        std::vector<std::pair<int, int>> sorted; // (neighbour, weight)
+        for (size_t u = 0; u < adj.size(); ++u)
+        {
+            offsets.push(bytes.size());
+            sorted.clear();
+            for (const auto &edge : adj[u])
+            {
+                if (weightFirst)
+                    sorted.push_back({edge.second, edge.first});
+                else
+                    sorted.push_back(edge);
+            }
+            std::sort(sorted.begin(), sorted.end());
+
+            compressed::putVarint(bytes, sorted.size());
+            int prev = (int)u;
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                if (i == 0)
+                    compressed::putVarint(bytes, compressed::zigzag(sorted[i].first - prev));
+                else
+                    compressed::putVarint(bytes, sorted[i].first - prev);
+                compressed::putVarint(bytes, sorted[i].second);
+                prev = sorted[i].first;
+            }
+        }
+        offsets.push(bytes.size());
+        bytes.shrink_to_fit();
+    }
+
+    size_t size() const
+    {
+        return offsets.size() == 0 ? 0 : offsets.size() - 1;
+    }
+
+    NeighbourRange operator[](int u) const
+    {
+        const uint8_t *p = bytes.data() + offsets[u];
+        uint32_t degree = compressed::getVarint(p);
+        return NeighbourRange(p, degree, u, weightFirst);
+    }
+
+    size_t memoryBytes() const
+    {
+        return bytes.capacity() + offsets.memoryBytes();
+    }
+
+private:
+    compressed::OffsetIndex offsets;
+    std::vector<uint8_t> bytes;
+    bool weightFirst = false;
+};
+
+// bytes used by an uncompressed vector<vector<T>> adjacency list
+template <typename T>
+size_t adjacencyBytes(const std::vector<std::vector<T>> &adj)
+{
+    size_t total = adj.capacity() * sizeof(std::vector<T>);
+    for (const auto &list : adj)
+        total += list.capacity() * sizeof(T);
+    return total;
+}
@@ -0,0 +1,221 @@
+/*
+Fast CSV loading for the TSP and route data files
+
+The file is mapped with mmap and parsed in place: fields are string_views
+into the mapping and numbers are read with from_chars, so no string is
+built per line or per field. Large files can be split into chunks (cut at
+line starts) that are parsed by separate threads and joined in order.
+
+Quotes are dropped rather than interpreted, which covers both plain
+files ("TSP Matrix.csv") and route_finding.csv, where every line,
+header included, is a single quoted string. None of our fields contain
+commas.
+
+  csv::loadRows(file, cols, values, threads)
+      the first cols fields of every row that are all numbers, row-major;
+      header and blank lines are skipped
+  csv::forEachRow(file, row)
+      calls row(fields, count) for every non-empty line, for mixed text
+      and number files
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+        if (base != nullptr)
+            munmap(base, length);
+    }
+
+    bool open(const std::string &filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        length = info.st_size;
+        if (length > 0)
+        {
+            void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                close(fd);
+                return false;
+            }
+            base = (char *)mapped;
+            madvise(base, length, MADV_SEQUENTIAL);
+        }
+        close(fd); // the mapping keeps the file alive
+        return true;
+    }
+
+    const char *begin() const { return base; }
+    const char *end() const { return base + length; }
+    size_t size() const { return length; }
+
+private:
+    char *base = nullptr;
+    size_t length = 0;
+};
+
+namespace csv
+{
+    // splits [first, last) at commas; quotes, spaces and '\r' around the
+    // fields are dropped. Returns the number of fields (at most maxFields)
+    inline size_t splitFields(const char *first, const char *last, std::string_view *fields, size_t maxFields)
+    {
+        auto trim = [](const char *&a, const char *&b)
+        {
+            while (a < b && (*a == ' ' || *a == '"' || *a == '\t'))
+                a++;
+            while (b > a && (b[-1] == ' ' || b[-1] == '"' || b[-1] == '\r' || b[-1] == '\t'))
+                b--;
+        };
+
+        size_t count = 0;
+        while (count < maxFields)
+        {
+            const char *comma = std::find(first, last, ',');
+            const char *a = first, *b = comma;
+            trim(a, b);
+            fields[count++] = std::string_view(a, b - a);
+            if (comma == last)
+                break;
+            first = comma + 1;
+        }
+        return count;
+    }
+
+    template <typename T>
+    bool parseNumber(std::string_view field, T &out)
+    {
+        const char *first = field.data();
+        const char *last = first + field.size();
+        if (first < last && *first == '+')
+            first++; // from_chars does not take a leading '+'
+        std::from_chars_result result = std::from_chars(first, last, out);
+        return result.ec == std::errc() && result.ptr == last && first < last;
+    }
+
+    // cuts [first, last) into at most parts pieces that start at line starts
+    inline std::vector<const char *> splitLines(const char *first, const char *last, int parts)
+    {
+        std::vector<const char *> cuts = {first};
+        size_t size = last - first;
+        for (int p = 1; p < parts; ++p)
+        {
+            const char *cut = std::max(cuts.back(), first + size * p / parts);
+            cut = std::find(cut, last, '\n');
+            if (cut != last)
+                cut++;
+            cuts.push_back(cut);
+        }
+        cuts.push_back(last);
+        return cuts;
+    }
+
+    template <typename T>
+    void parseRows(const char *first, const char *last, size_t cols, std::vector<T> &values)
+    {
+        std::vector<std::string_view> fields(cols);
+        std::vector<T> row(cols);
+        while (first < last)
+        {
+            const char *eol = std::find(first, last, '\n');
+            if (splitFields(first, eol, fields.data(), cols) == cols)
+            {
+                size_t c = 0;
+                while (c < cols && parseNumber(fields[c], row[c]))
+                    c++;
+                if (c == cols)
+                    values.insert(values.end(), row.begin(), row.end());
+            }
+            first = eol + (eol < last);
+        }
+    }
+
+    // false only if the file cannot be opened
+    template <typename T>
+    bool loadRows(const std::string &filename, size_t cols, std::vector<T> &values, int numThreads = 1)
+    {
+        values.clear();
+        MappedFile file;
+        if (!file.open(filename))
+            return false;
+
+        // below ~1 MB per thread the threads cost more than they save
+        const size_t MIN_CHUNK = 1 << 20;
+        int parts = std::max<size_t>(1, std::min<size_t>(std::max(1, numThreads), file.size() / MIN_CHUNK));
+        if (parts == 1)
+        {
+            parseRows(file.begin(), file.end(), cols, values);
+            return true;
+        }
+
+        std::vector<const char *> cuts = splitLines(file.begin(), file.end(), parts);
+        std::vector<std::vector<T>> chunks(parts);
+        std::vector<std::thread> workers;
+        for (int p = 0; p < parts; ++p)
+            workers.emplace_back([&, p]()
+                                 { parseRows(cuts[p], cuts[p + 1], cols, chunks[p]); });
+        for (std::thread &w : workers)
+            w.join();
+
+        size_t total = 0;
+        for (const std::vector<T> &chunk : chunks)
+            total += chunk.size();
+        values.reserve(total);
+        for (const std::vector<T> &chunk : chunks)
+            values.insert(values.end(), chunk.begin(), chunk.end());
+        return true;
+    }
+
+    // row(const std::string_view *fields, size_t count) for every
+    // non-empty line, at most maxFields fields each
+    template <typename Row>
+    bool forEachRow(const std::string &filename, Row row, size_t maxFields = 64)
+    {
+        MappedFile file;
+        if (!file.open(filename))
+            return false;
+
+        std::vector<std::string_view> fields(maxFields);
+        const char *first = file.begin(), *last = file.end();
+        while (first < last)
+        {
+            const char *eol = std::find(first, last, '\n');
+            size_t count = splitFields(first, eol, fields.data(), maxFields);
+            if (count > 1 || !fields[0].empty())
+                row((const std::string_view *)fields.data(), count);
+            first = eol + (eol < last);
+        }
+        return true;
+    }
+}
@@ -4,8 +4,13 @@ Simple example of Deep First Search
 
 #include <vector>
 #include <stack>
+#include <iterator>
+#include <type_traits>
 #include <iostream>
 
+#include "compressed_graph.h"
+#include "components.h"
+
 using namespace std;
 
 struct Node
@@ -17,7 +22,11 @@ struct Node
 class DFS
 {
 public:
-    Node *findPath(vector<vector<int>> &adj, int S, int T)
+    // Graph is vector<vector<int>> or anything shaped like it, such as
+    // CompressedGraph. If a ComponentIndex is given, targets in another
+    // component are rejected before searching
+    template <typename Graph>
+    Node *findPath(const Graph &adj, int S, int T, const ComponentIndex *components = nullptr)
     {
         if (S == T)
         {
@@ -25,6 +34,9 @@ public:
             return head;
         }
 
+        if (components != nullptr && !components->mayReach(S, T))
+            return nullptr; // different components, nothing to explore
+
         stack<int> s;
         int n = adj.size();
         vector<bool> visited(n, 0);
@@ -33,14 +45,17 @@ public:
         visited[S] = true;
         s.push(S);
         vector<int> parents(n, -1);
+        vector<int> neighs; // compressed lists can only be decoded forwards
         while (!s.empty() && !found)
         {
             int U = s.top();
             s.pop();
 
-            for (int i = (int)adj[U].size() - 1; i >= 0; --i)
+            // neighbours are pushed last to first, so the first is explored first
+            const auto &list = adj[U];
+            typedef typename iterator_traits<decltype(list.begin())>::iterator_category Category;
+            auto visit = [&](int N)
             {
-                int N = adj[U][i];
                 if (!visited[N])
                 {
                     visited[N] = true;
@@ -51,8 +66,24 @@ public:
                     }
                     s.push(N);
                 }
-                if (found)
-                    break;
+                return found;
+            };
+            if constexpr (is_base_of_v<bidirectional_iterator_tag, Category>)
+            {
+                for (auto it = list.end(); it != list.begin();)
+                {
+                    if (visit(*--it))
+                        break;
+                }
+            }
+            else
+            {
+                neighs.assign(list.begin(), list.end());
+                for (int i = (int)neighs.size() - 1; i >= 0; --i)
+                {
+                    if (visit(neighs[i]))
+                        break;
+                }
             }
         }
 
@@ -113,4 +144,16 @@ int main()
     Node *head = dfs.findPath(adj, 0, 3);
     dfs.printPath(head);
     dfs.deletePath(head);
+
+    // same search over the delta + varint encoded lists
+    CompressedGraph packed(adj);
+    head = dfs.findPath(packed, 0, 3);
+    dfs.printPath(head);
+    dfs.deletePath(head);
+
+    // 3 cannot reach 0: the component index answers without searching
+    ComponentIndex components;
+    components.build(adj, true);
+    head = dfs.findPath(adj, 3, 0, &components);
+    cout << (head ? "Path found" : "No path from 3 to 0") << endl;
 }
\ No newline at end of file
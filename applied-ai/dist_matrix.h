@@ -0,0 +1,167 @@
+/*
+Flat Euclidean distance matrix for the TSP solvers
+
+Replaces the jagged vector<vector<double>> built by calcDist (one
+allocation per row, min/max and an offset on every lookup):
+
+  FULL        n x n, rows padded to a multiple of 8 doubles and 64-byte
+              aligned; d(i, j) is one load from i * stride + j
+  TRIANGULAR  packed lower triangle with the diagonal, about half the
+              memory; d(i, j) uses min/max, which compile to cmov, so the
+              lookup is branch free as well
+
+The coordinates are copied into separate x and y arrays (structure of
+arrays) and every row is computed with SSE2, or AVX when the compiler
+targets it (-mavx), four or two distances per instruction. Rows are
+dealt round-robin to threads, which balances the triangular layout too.
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstddef>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+class DistMatrix
+{
+public:
+    enum Layout
+    {
+        FULL,
+        TRIANGULAR
+    };
+
+    DistMatrix() = default;
+
+    // points need .X and .Y, like Point in the TSP solvers
+    template <typename P>
+    explicit DistMatrix(const std::vector<P> &points, Layout layout = FULL,
+                        int numThreads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        std::vector<double> xs(points.size()), ys(points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            xs[i] = points[i].X;
+            ys[i] = points[i].Y;
+        }
+        build(xs, ys, layout, numThreads);
+    }
+
+    DistMatrix(const std::vector<double> &xs, const std::vector<double> &ys, Layout layout = FULL,
+               int numThreads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        build(xs, ys, layout, numThreads);
+    }
+
+    double operator()(int i, int j) const
+    {
+        if (layout == FULL)
+            return data[(size_t)i * stride + j];
+
+        size_t hi = std::max(i, j), lo = std::min(i, j);
+        return data[hi * (hi + 1) / 2 + lo];
+    }
+
+    // the n distances from i, for vectorised scans; FULL layout only
+    const double *row(int i) const
+    {
+        return layout == FULL ? data.get() + (size_t)i * stride : nullptr;
+    }
+
+    // true when row() is usable
+    bool hasRows() const
+    {
+        return layout == FULL;
+    }
+
+    int size() const
+    {
+        return n;
+    }
+
+    size_t memoryBytes() const
+    {
+        return allocated * sizeof(double);
+    }
+
+    // out[j] = |p_i - p_j| for j in [0, count), from separate x and y arrays
+    static void fillRow(const double *xs, const double *ys, int i, int count, double *out)
+    {
+        int j = 0;
+#if defined(__AVX__)
+        __m256d xi4 = _mm256_set1_pd(xs[i]), yi4 = _mm256_set1_pd(ys[i]);
+        for (; j + 4 <= count; j += 4)
+        {
+            __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + j), xi4);
+            __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + j), yi4);
+            __m256d sq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            _mm256_storeu_pd(out + j, _mm256_sqrt_pd(sq));
+        }
+#elif defined(__SSE2__)
+        __m128d xi2 = _mm_set1_pd(xs[i]), yi2 = _mm_set1_pd(ys[i]);
+        for (; j + 2 <= count; j += 2)
+        {
+            __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + j), xi2);
+            __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + j), yi2);
+            __m128d sq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+            _mm_storeu_pd(out + j, _mm_sqrt_pd(sq));
+        }
+#endif
+        for (; j < count; ++j)
+        {
+            double dx = xs[j] - xs[i], dy = ys[j] - ys[i];
+            out[j] = std::sqrt(dx * dx + dy * dy);
+        }
+    }
+
+private:
+    struct FreeDeleter
+    {
+        void operator()(double *p) const { free(p); }
+    };
+
+    int n = 0;
+    Layout layout = FULL;
+    size_t stride = 0;
+    size_t allocated = 0;
+    std::unique_ptr<double[], FreeDeleter> data;
+
+    void build(const std::vector<double> &xs, const std::vector<double> &ys, Layout layout, int numThreads)
+    {
+        n = xs.size();
+        this->layout = layout;
+        stride = (n + 7) & ~(size_t)7;
+
+        size_t count = layout == FULL ? stride * n : (size_t)n * (n + 1) / 2;
+        allocated = (count + 7) & ~(size_t)7; // aligned_alloc wants a multiple of the alignment
+        data.reset((double *)aligned_alloc(64, std::max<size_t>(allocated, 8) * sizeof(double)));
+        if (!data)
+            throw std::bad_alloc();
+
+        numThreads = std::max(1, std::min(numThreads, n / 256 + 1));
+        std::vector<std::thread> workers;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            workers.emplace_back([&, t]()
+                                 {
+                                     for (int i = t; i < n; i += numThreads)
+                                     {
+                                         if (this->layout == FULL)
+                                             fillRow(xs.data(), ys.data(), i, n, data.get() + (size_t)i * stride);
+                                         else
+                                             fillRow(xs.data(), ys.data(), i, i + 1, data.get() + (size_t)i * (i + 1) / 2);
+                                     } });
+        }
+        for (std::thread &w : workers)
+            w.join();
+    }
+};
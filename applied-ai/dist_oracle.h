@@ -0,0 +1,140 @@
+/*
+Euclidean distances computed on demand, for instances too large for a
+DistMatrix (n^2 doubles: 80 GB at 100k cities)
+
+Only the coordinates are kept, as separate x and y arrays (structure of
+arrays, 16 bytes per city). d(i, j) is recomputed on every call, which
+costs a couple of loads and a square root instead of one load, so it
+plugs in wherever DistMatrix does: operator()(i, j) and size(), the
+d(u, v) lambdas of the solvers, tsp_moves.h and tsp_local_search.h.
+
+The bulk operations use SIMD, like DistMatrix:
+
+  row(i, out)                    all n distances from i (AVX or SSE2)
+  distances(i, js, count, out)   distances from i to a list of cities,
+                                 gathering the coordinates (AVX2)
+  tourLength(tour)               gathers consecutive cities, four edges
+                                 per instruction
+
+Caching the candidate-list edge distances was tried and dropped: finding
+j among i's k candidates costs more than the square root it saves (about
+25% slower on 100k uniform cities with k = 8).
+*/
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+#include "dist_matrix.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+class DistOracle
+{
+public:
+    DistOracle() = default;
+
+    // points need .X and .Y, like Point in the TSP solvers
+    template <typename P>
+    explicit DistOracle(const std::vector<P> &points) : xs(points.size()), ys(points.size())
+    {
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            xs[i] = points[i].X;
+            ys[i] = points[i].Y;
+        }
+    }
+
+    DistOracle(const std::vector<double> &xs, const std::vector<double> &ys) : xs(xs), ys(ys) {}
+
+    double operator()(int i, int j) const
+    {
+        double dx = xs[i] - xs[j], dy = ys[i] - ys[j];
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    int size() const
+    {
+        return xs.size();
+    }
+
+    // out[j] = d(i, j) for all j
+    void row(int i, double *out) const
+    {
+        DistMatrix::fillRow(xs.data(), ys.data(), i, size(), out);
+    }
+
+    // out[k] = d(i, js[k]) for k in [0, count)
+    void distances(int i, const int *js, int count, double *out) const
+    {
+        int k = 0;
+#if defined(__AVX2__)
+        __m256d xi4 = _mm256_set1_pd(xs[i]), yi4 = _mm256_set1_pd(ys[i]);
+        for (; k + 4 <= count; k += 4)
+        {
+            __m128i idx = _mm_loadu_si128((const __m128i *)(js + k));
+            __m256d dx = _mm256_sub_pd(gather(xs.data(), idx), xi4);
+            __m256d dy = _mm256_sub_pd(gather(ys.data(), idx), yi4);
+            __m256d sq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            _mm256_storeu_pd(out + k, _mm256_sqrt_pd(sq));
+        }
+#endif
+        for (; k < count; ++k)
+        {
+            double dx = xs[i] - xs[js[k]], dy = ys[i] - ys[js[k]];
+            out[k] = std::sqrt(dx * dx + dy * dy);
+        }
+    }
+
+    // length of the closed tour
+    double tourLength(const std::vector<int> &tour) const
+    {
+        int n = tour.size();
+        if (n < 2)
+            return 0.0;
+
+        double total = 0.0;
+        int k = 0;
+#if defined(__AVX2__)
+        __m256d sum = _mm256_setzero_pd();
+        for (; k + 4 < n; k += 4)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(tour.data() + k));
+            __m128i b = _mm_loadu_si128((const __m128i *)(tour.data() + k + 1));
+            __m256d dx = _mm256_sub_pd(gather(xs.data(), a), gather(xs.data(), b));
+            __m256d dy = _mm256_sub_pd(gather(ys.data(), a), gather(ys.data(), b));
+            sum = _mm256_add_pd(sum, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, sum);
+        total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; k < n; ++k)
+        {
+            int a = tour[k], b = tour[k + 1 == n ? 0 : k + 1];
+            double dx = xs[a] - xs[b], dy = ys[a] - ys[b];
+            total += std::sqrt(dx * dx + dy * dy);
+        }
+        return total;
+    }
+
+    size_t memoryBytes() const
+    {
+        return (xs.size() + ys.size()) * sizeof(double);
+    }
+
+private:
+    std::vector<double> xs, ys;
+
+#if defined(__AVX2__)
+    static __m256d gather(const double *base, __m128i idx)
+    {
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, idx, all, 8);
+    }
+#endif
+};
@@ -0,0 +1,695 @@
+/*
+Simple implementation of an external-memory (out-of-core) Breadth First Search
+
+The graph never has to fit in RAM. The adjacency lists live in a binary
+file that is only ever read front to back, and every BFS level lives in
+its own sorted run file of (node, parent) pairs:
+
+  1. the sorted frontier is merge-joined with the adjacency file, and the
+     neighbours it produces are buffered, sorted and spilled as runs;
+  2. the runs are k-way merged, which removes the duplicates and drops
+     every node that was already visited (again a sequential merge);
+  3. the result is the next sorted frontier.
+
+For undirected graphs it is enough to subtract the previous two levels
+(Munagala-Ranade), for directed graphs a sorted file with every visited
+node is kept and merged with each new level.
+
+All I/O is sequential, so the speed depends on the disk bandwidth and
+not on random seeks. Each level costs at most one scan of the adjacency
+file (it stops after the largest frontier node) plus the merges. The memory budget bounds the size of the sort
+buffer and of the read/write blocks.
+
+Adjacency file layout (all uint32): n, then for every node u in
+increasing order: u, degree, neighbours...
+*/
+
+#include <vector>
+#include <queue>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <filesystem>
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <memory>
+#include <system_error>
+#include <cstdlib>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+struct Node
+{
+    int id;
+    Node *next;
+};
+
+struct ExternalBFSStats
+{
+    int levels = 0;
+    long long runsWritten = 0;
+    long long bytesRead = 0;
+    long long bytesWritten = 0;
+};
+
+// (node, parent) pair stored in the level and run files
+struct Visit
+{
+    uint32_t node;
+    uint32_t parent;
+};
+
+template <typename T>
+class BlockReader
+{
+private:
+    FILE *file = nullptr;
+    vector<T> block;
+    size_t pos = 0;
+    size_t len = 0;
+    bool failed = false;
+    long long *bytesRead;
+
+    bool fill()
+    {
+        len = fread(block.data(), sizeof(T), block.size(), file);
+        pos = 0;
+        *bytesRead += len * sizeof(T);
+        if (len == 0 && ferror(file))
+            failed = true;
+        return len > 0;
+    }
+
+public:
+    BlockReader(const string &filename, size_t blockRecords, long long *counter)
+        : block(max<size_t>(blockRecords, 1)), bytesRead(counter)
+    {
+        file = fopen(filename.c_str(), "rb");
+    }
+
+    ~BlockReader()
+    {
+        if (file)
+            fclose(file);
+    }
+
+    // false if the file could not be opened or a read failed; the end of
+    // the file is not an error
+    bool ok() const
+    {
+        return file != nullptr && !failed;
+    }
+
+    bool next(T &out)
+    {
+        if (pos == len && (!file || !fill()))
+            return false;
+        out = block[pos++];
+        return true;
+    }
+};
+
+template <typename T>
+class BlockWriter
+{
+private:
+    FILE *file = nullptr;
+    vector<T> block;
+    bool failed = false;
+    long long *bytesWritten;
+
+public:
+    BlockWriter(const string &filename, size_t blockRecords, long long *counter)
+        : bytesWritten(counter)
+    {
+        block.reserve(max<size_t>(blockRecords, 1));
+        file = fopen(filename.c_str(), "wb");
+        failed = file == nullptr;
+    }
+
+    ~BlockWriter()
+    {
+        close();
+    }
+
+    void push(const T &value)
+    {
+        block.push_back(value);
+        if (block.size() == block.capacity())
+            flush();
+    }
+
+    void flush()
+    {
+        if (file && !block.empty())
+        {
+            if (fwrite(block.data(), sizeof(T), block.size(), file) != block.size())
+                failed = true;
+            *bytesWritten += block.size() * sizeof(T);
+        }
+        block.clear();
+    }
+
+    // flushes and closes the file; false if anything was not written
+    bool close()
+    {
+        flush();
+        if (file && fclose(file) != 0)
+            failed = true;
+        file = nullptr;
+        return !failed;
+    }
+};
+
+// writes an in-memory adjacency list in the on-disk format used below
+bool writeAdjacencyFile(const vector<vector<int>> &adj, const string &filename)
+{
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool ok = true;
+    uint32_t n = adj.size();
+    ok = ok && fwrite(&n, sizeof(n), 1, file) == 1;
+    for (uint32_t u = 0; u < n && ok; ++u)
+    {
+        uint32_t header[2] = {u, (uint32_t)adj[u].size()};
+        ok = fwrite(header, sizeof(uint32_t), 2, file) == 2;
+        for (int v : adj[u])
+        {
+            uint32_t w = v;
+            ok = ok && fwrite(&w, sizeof(w), 1, file) == 1;
+        }
+    }
+    return fclose(file) == 0 && ok;
+}
+
+class ExternalBFS
+{
+private:
+    fs::path baseDir;
+    fs::path workDir;
+    size_t memoryBytes;
+    bool undirected;
+    ExternalBFSStats stats;
+    string error;
+    vector<string> created; // every file this search wrote in workDir
+
+    // keeps the first error, returns false so callers can pass it on
+    bool fail(const string &message)
+    {
+        if (error.empty())
+            error = message;
+        return false;
+    }
+
+    size_t blockRecords(size_t recordSize, size_t streams) const
+    {
+        // every open stream gets an equal share of the budget
+        return max<size_t>(memoryBytes / (recordSize * max<size_t>(streams, 1)), 64);
+    }
+
+    string levelFile(int level) const
+    {
+        return (workDir / ("level_" + to_string(level) + ".bin")).string();
+    }
+
+    string runFile(long long run) const
+    {
+        return (workDir / ("run_" + to_string(run) + ".bin")).string();
+    }
+
+    // a writer for a file in workDir, remembered for the clean-up
+    unique_ptr<BlockWriter<Visit>> create(const string &name, size_t block)
+    {
+        created.push_back(name);
+        return make_unique<BlockWriter<Visit>>(name, block, &stats.bytesWritten);
+    }
+
+    // a fresh directory under baseDir, so concurrent searches never share
+    // their files
+    bool makeWorkDir()
+    {
+        error_code ec;
+        fs::create_directories(baseDir, ec);
+        string pattern = (baseDir / "external_bfs_XXXXXX").string();
+        vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        if (mkdtemp(name.data()) == nullptr)
+            return fail("cannot create a work directory in " + baseDir.string());
+        workDir = name.data();
+        return true;
+    }
+
+    // removes the files this search created and then its (now empty)
+    // directory, nothing else
+    void cleanUp()
+    {
+        error_code ec;
+        for (const string &name : created)
+            fs::remove(name, ec);
+        created.clear();
+        if (!workDir.empty())
+            fs::remove(workDir, ec);
+        workDir.clear();
+    }
+
+    // merge-join the sorted frontier with the adjacency file and spill
+    // the generated (neighbour, parent) pairs as sorted runs
+    bool expand(const string &adjFile, const string &frontierFile, vector<string> &runs)
+    {
+        vector<Visit> buffer;
+        buffer.reserve(max<size_t>(memoryBytes / 2 / sizeof(Visit), 1));
+
+        auto spill = [&]()
+        {
+            if (buffer.empty())
+                return true;
+            sort(buffer.begin(), buffer.end(), [](const Visit &a, const Visit &b)
+                 { return a.node < b.node; });
+            string name = runFile(stats.runsWritten++);
+            unique_ptr<BlockWriter<Visit>> out = create(name, blockRecords(sizeof(Visit), 4));
+            for (const Visit &v : buffer)
+                out->push(v);
+            runs.push_back(name);
+            buffer.clear();
+            return out->close() || fail("cannot write " + name);
+        };
+
+        BlockReader<uint32_t> adjacency(adjFile, blockRecords(sizeof(uint32_t), 4), &stats.bytesRead);
+        BlockReader<Visit> frontier(frontierFile, blockRecords(sizeof(Visit), 4), &stats.bytesRead);
+        if (!adjacency.ok())
+            return fail("cannot open " + adjFile);
+        if (!frontier.ok())
+            return fail("cannot open " + frontierFile);
+
+        uint32_t n;
+        Visit curr;
+        bool hasCurr = frontier.next(curr);
+        if (!adjacency.next(n))
+            return fail("empty adjacency file " + adjFile);
+
+        uint32_t header[2];
+        while (hasCurr && adjacency.next(header[0]))
+        {
+            if (!adjacency.next(header[1]))
+                return fail("truncated adjacency file " + adjFile);
+            uint32_t u = header[0];
+            uint32_t degree = header[1];
+
+            while (hasCurr && curr.node < u)
+                hasCurr = frontier.next(curr);
+
+            bool expandU = hasCurr && curr.node == u;
+            for (uint32_t i = 0; i < degree; ++i)
+            {
+                uint32_t v;
+                if (!adjacency.next(v))
+                    return fail("truncated adjacency file " + adjFile);
+                if (expandU)
+                {
+                    buffer.push_back({v, u});
+                    if (buffer.size() == buffer.capacity() && !spill())
+                        return false;
+                }
+            }
+        }
+        if (!adjacency.ok())
+            return fail("cannot read " + adjFile);
+        if (!frontier.ok())
+            return fail("cannot read " + frontierFile);
+        return spill();
+    }
+
+    // k-way merge of sorted run files into one sorted file; if keepFirst
+    // is set, only the first pair of every node is kept. Every file in
+    // subtract is sorted by node and removes its nodes from the output
+    bool merge(const vector<string> &inputs, const string &output, bool keepFirst,
+               const vector<string> &subtract)
+    {
+        size_t streams = inputs.size() + subtract.size() + 1;
+        size_t block = blockRecords(sizeof(Visit), streams);
+
+        vector<unique_ptr<BlockReader<Visit>>> readers;
+        for (const string &name : inputs)
+        {
+            readers.push_back(make_unique<BlockReader<Visit>>(name, block, &stats.bytesRead));
+            if (!readers.back()->ok())
+                return fail("cannot open " + name);
+        }
+
+        vector<unique_ptr<BlockReader<Visit>>> minus;
+        vector<Visit> minusHead(subtract.size());
+        vector<bool> minusLive(subtract.size());
+        for (size_t i = 0; i < subtract.size(); ++i)
+        {
+            minus.push_back(make_unique<BlockReader<Visit>>(subtract[i], block, &stats.bytesRead));
+            if (!minus[i]->ok())
+                return fail("cannot open " + subtract[i]);
+            minusLive[i] = minus[i]->next(minusHead[i]);
+        }
+
+        // (node, reader) ordered by node, then by reader for stable parents
+        typedef pair<Visit, size_t> Head;
+        auto cmp = [](const Head &a, const Head &b)
+        {
+            if (a.first.node != b.first.node)
+                return a.first.node > b.first.node;
+            return a.second > b.second;
+        };
+        priority_queue<Head, vector<Head>, decltype(cmp)> pq(cmp);
+
+        for (size_t i = 0; i < readers.size(); ++i)
+        {
+            Visit v;
+            if (readers[i]->next(v))
+                pq.push({v, i});
+        }
+
+        unique_ptr<BlockWriter<Visit>> out = create(output, block);
+        bool hasLast = false;
+        uint32_t last = 0;
+
+        while (!pq.empty())
+        {
+            auto [v, idx] = pq.top();
+            pq.pop();
+
+            Visit nextV;
+            if (readers[idx]->next(nextV))
+                pq.push({nextV, idx});
+
+            if (keepFirst && hasLast && v.node == last)
+                continue;
+            hasLast = true;
+            last = v.node;
+
+            bool seen = false;
+            for (size_t i = 0; i < minus.size(); ++i)
+            {
+                while (minusLive[i] && minusHead[i].node < v.node)
+                    minusLive[i] = minus[i]->next(minusHead[i]);
+                if (minusLive[i] && minusHead[i].node == v.node)
+                    seen = true;
+            }
+
+            if (!seen)
+                out->push(v);
+        }
+
+        for (size_t i = 0; i < readers.size(); ++i)
+            if (!readers[i]->ok())
+                return fail("cannot read " + inputs[i]);
+        for (size_t i = 0; i < minus.size(); ++i)
+            if (!minus[i]->ok())
+                return fail("cannot read " + subtract[i]);
+        return out->close() || fail("cannot write " + output);
+    }
+
+    // merges runs until they fit the fan-in allowed by the budget
+    bool mergeRuns(vector<string> runs, const vector<string> &subtract, const string &output)
+    {
+        size_t fanIn = max<size_t>(memoryBytes / (64 * 1024), 2);
+
+        while (runs.size() > fanIn)
+        {
+            vector<string> merged;
+            for (size_t i = 0; i < runs.size(); i += fanIn)
+            {
+                vector<string> group(runs.begin() + i, runs.begin() + min(runs.size(), i + fanIn));
+                string name = runFile(stats.runsWritten++);
+                if (!merge(group, name, true, {}) || !removeRuns(group))
+                    return false;
+                merged.push_back(name);
+            }
+            runs = merged;
+        }
+
+        return merge(runs, output, true, subtract) && removeRuns(runs);
+    }
+
+    // deletes merged runs early, so they do not pile up on disk
+    bool removeRuns(const vector<string> &runs)
+    {
+        for (const string &r : runs)
+        {
+            error_code ec;
+            fs::remove(r, ec);
+            if (ec)
+                return fail("cannot remove " + r);
+        }
+        return true;
+    }
+
+    // found is set if node is in the sorted file, with its parent
+    bool containsNode(const string &filename, uint32_t node, uint32_t &parent, bool &found)
+    {
+        BlockReader<Visit> reader(filename, blockRecords(sizeof(Visit), 1), &stats.bytesRead);
+        found = false;
+        Visit v;
+        while (reader.next(v) && v.node <= node)
+        {
+            if (v.node == node)
+            {
+                parent = v.parent;
+                found = true;
+                break;
+            }
+        }
+        return reader.ok() || fail("cannot read " + filename);
+    }
+
+    // the BFS proper; head gets the path, nullptr if T is unreachable
+    bool search(const string &adjFile, int S, int T, Node *&head)
+    {
+        {
+            unique_ptr<BlockWriter<Visit>> start = create(levelFile(0), 1);
+            start->push({(uint32_t)S, (uint32_t)S});
+            if (!start->close())
+                return fail("cannot write " + levelFile(0));
+        }
+
+        string visitedFile = (workDir / "visited.bin").string();
+        if (!undirected)
+        {
+            error_code ec;
+            created.push_back(visitedFile);
+            if (!fs::copy_file(levelFile(0), visitedFile, ec))
+                return fail("cannot write " + visitedFile);
+        }
+
+        int level = 0;
+        bool found = false;
+        uint32_t parent = 0;
+        while (!found)
+        {
+            vector<string> runs;
+            if (!expand(adjFile, levelFile(level), runs))
+                return false;
+
+            vector<string> subtract;
+            if (undirected)
+            {
+                subtract.push_back(levelFile(level));
+                if (level > 0)
+                    subtract.push_back(levelFile(level - 1));
+            }
+            else
+            {
+                subtract.push_back(visitedFile);
+            }
+
+            string nextFile = levelFile(level + 1);
+            if (!mergeRuns(runs, subtract, nextFile))
+                return false;
+            error_code ec;
+            uintmax_t nextBytes = fs::file_size(nextFile, ec);
+            if (ec)
+                return fail("cannot read " + nextFile);
+            if (nextBytes == 0)
+                break;
+
+            level++;
+            if (!containsNode(nextFile, T, parent, found))
+                return false;
+
+            if (!undirected && !found)
+            {
+                string mergedVisited = (workDir / "visited_next.bin").string();
+                if (!merge({visitedFile, nextFile}, mergedVisited, true, {}))
+                    return false;
+                error_code ec;
+                fs::rename(mergedVisited, visitedFile, ec);
+                if (ec)
+                    return fail("cannot replace " + visitedFile);
+            }
+        }
+        stats.levels = level;
+
+        if (found)
+        {
+            // walk the level files backwards to recover the parents
+            head = new Node{T, nullptr};
+            uint32_t curr = parent;
+            for (int l = level - 1; l >= 0; --l)
+            {
+                head = new Node{(int)curr, head};
+                bool present;
+                if (l > 0 && !containsNode(levelFile(l), curr, curr, present))
+                {
+                    deletePath(head);
+                    head = nullptr;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    // memoryBytes bounds the sort buffer and the I/O blocks; every search
+    // keeps its temporary level and run files in a directory of its own
+    // under baseDir, removed again when it ends
+    ExternalBFS(size_t memoryBytes, bool undirected = false,
+                const fs::path &baseDir = fs::temp_directory_path())
+        : baseDir(baseDir), memoryBytes(max<size_t>(memoryBytes, 4096)), undirected(undirected)
+    {
+    }
+
+    // the path from S to T, nullptr if there is none or the search failed
+    // (then lastError() says why)
+    Node *findPath(const string &adjFile, int S, int T)
+    {
+        stats = ExternalBFSStats{};
+        error.clear();
+        if (S == T)
+            return new Node{S, nullptr};
+
+        Node *head = nullptr;
+        if (makeWorkDir())
+            search(adjFile, S, T, head);
+        cleanUp();
+        return head;
+    }
+
+    // empty unless the last search hit an I/O error
+    const string &lastError() const
+    {
+        return error;
+    }
+
+    const ExternalBFSStats &lastStats() const
+    {
+        return stats;
+    }
+
+    void printPath(Node *head)
+    {
+        if (head == nullptr)
+            return;
+
+        while (head->next != nullptr)
+        {
+            cout << head->id << "->";
+            head = head->next;
+        }
+        cout << head->id << endl;
+    }
+
+    void deletePath(Node *head)
+    {
+        if (head == nullptr)
+            return;
+
+        Node *curr = head;
+        while (curr->next != nullptr)
+        {
+            Node *nextNode = curr->next;
+            delete curr;
+            curr = nextNode;
+        }
+        delete curr;
+    }
+};
+
+int main()
+{
+    vector<vector<int>> adj = {
+        {1, 2},
+        {3},
+        {3},
+        {}};
+
+    string adjFile = (fs::temp_directory_path() / "external_bfs_small.adj").string();
+    if (!writeAdjacencyFile(adj, adjFile))
+    {
+        cerr << "Cannot write " << adjFile << endl;
+        return 1;
+    }
+
+    ExternalBFS bfs(1 << 20);
+    Node *head = bfs.findPath(adjFile, 0, 3);
+    bfs.printPath(head);
+    bfs.deletePath(head);
+
+    // a missing input is an error, not "no path"
+    Node *missing = bfs.findPath(adjFile + ".missing", 0, 3);
+    if (missing == nullptr && !bfs.lastError().empty())
+        cout << "Error: " << bfs.lastError() << endl;
+
+    // a larger undirected grid with a tiny budget, so that the frontier
+    // is spilled into many runs and merged in several passes
+    int side = 300;
+    vector<vector<int>> grid(side * side);
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            int u = y * side + x;
+            if (x + 1 < side)
+            {
+                grid[u].push_back(u + 1);
+                grid[u + 1].push_back(u);
+            }
+            if (y + 1 < side)
+            {
+                grid[u].push_back(u + side);
+                grid[u + side].push_back(u);
+            }
+        }
+    }
+
+    string gridFile = (fs::temp_directory_path() / "external_bfs_grid.adj").string();
+    if (!writeAdjacencyFile(grid, gridFile))
+    {
+        cerr << "Cannot write " << gridFile << endl;
+        return 1;
+    }
+    grid.clear();
+
+    ExternalBFS gridBfs(64 * 1024, true);
+    Node *path = gridBfs.findPath(gridFile, 0, side * side - 1);
+    if (path == nullptr && !gridBfs.lastError().empty())
+    {
+        cerr << "Error: " << gridBfs.lastError() << endl;
+        return 1;
+    }
+
+    int length = 0;
+    for (Node *curr = path; curr && curr->next; curr = curr->next)
+        length++;
+
+    const ExternalBFSStats &stats = gridBfs.lastStats();
+    cout << "Grid " << side << "x" << side << ": path with " << length << " edges, "
+         << stats.levels << " levels, " << stats.runsWritten << " runs, "
+         << stats.bytesRead / (1024 * 1024) << " MB read, "
+         << stats.bytesWritten / (1024 * 1024) << " MB written" << endl;
+
+    gridBfs.deletePath(path);
+    fs::remove(adjFile);
+    fs::remove(gridFile);
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+import json
+import os
+import socket
+import subprocess
+from itertools import count
+from typing import List, Optional, Tuple
+
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+class RouteServerClient:
+    """
+    Local client for the C++ route server (applied-ai/route_server.cpp).
+    Either starts the server as a child process and talks to it over stdin/stdout,
+    or connects to an already running server with --socket PATH.
+    """
+
+    def __init__(self, server_bin: str = os.path.join(HERE, "..", "route_server"),
+                 graph_file: str = os.path.join(HERE, "data", "route_finding.csv"),
+                 socket_path: Optional[str] = None):
+        self._ids = count(1)
+        self._proc = None
+        self._sock = None
+        if socket_path:
+            self._sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            self._sock.connect(socket_path)
+            self._reader = self._sock.makefile("r", encoding="utf-8")
+            self._writer = self._sock.makefile("w", encoding="utf-8")
+        else:
+            self._proc = subprocess.Popen(
+                [server_bin, graph_file], stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True, bufsize=1
+            )
+            self._reader = self._proc.stdout
+            self._writer = self._proc.stdin
+
+    def query_many(self, queries: List[Tuple[str, str, Optional[str]]]) -> List[Tuple[List[str], float]]:
+        """Send (start, goal, avoid) queries in one go, so the server can batch them."""
+        ids = []
+        for start, goal, avoid in queries:
+            qid = next(self._ids)
+            ids.append(qid)
+            msg = {"id": qid, "from": start, "to": goal}
+            if avoid:
+                msg["avoid"] = avoid
+            self._writer.write(json.dumps(msg) + "\n")
+        self._writer.flush()
+
+        answers = {}
+        while len(answers) < len(ids):
+            reply = json.loads(self._reader.readline())
+            answers[reply["id"]] = reply
+
+        results = []
+        for qid in ids:
+            reply = answers[qid]
+            if reply.get("found"):
+                results.append((reply["path"], float(reply["cost"])))
+            else:
+                results.append(([], float("inf")))
+        return results
+
+    def query(self, start: str, goal: str, avoid: Optional[str] = None) -> Tuple[List[str], float]:
+        """Same (path, cost) result as route_finder.dijkstra, computed by the server."""
+        return self.query_many([(start, goal, avoid)])[0]
+
+    def close(self):
+        if self._proc:
+            self._proc.stdin.close()
+            self._proc.wait()
+        if self._sock:
+            self._sock.close()
+
+
+if __name__ == "__main__":
+    client = RouteServerClient()
+    path, cost = client.query("York", "Portsmouth", avoid="London")
+    print(f"Path: {' -> '.join(path)}\nCost: {cost}")
+    client.close()
@@ -0,0 +1,418 @@
+/*
+Simple implementation of Hash Distributed A* (HDA*)
+
+Every state is owned by exactly one worker thread, chosen by hashing the
+state. Each worker keeps its own open list and closed table for the
+states it owns, so none of them are shared. When a worker generates a
+successor it sends it to the owner, batched per destination, through a
+lock-free inbox (a Treiber stack of batches: senders push with CAS, the
+owner takes the whole stack with one exchange).
+
+The search space is implicit, described by a Problem:
+
+  typedef ... State;                              copyable, ==
+  typedef ... Cost;                               integral, edge costs > 0
+  State start() const;
+  bool isGoal(const State &) const;
+  Cost heuristic(const State &) const;            admissible
+  void successors(const State &, vector<pair<State, Cost>> &) const;
+  size_t hash(const State &) const;
+
+Optimality: a goal only becomes the incumbent when its owner pops it, and
+every node with f >= incumbent is pruned. The search stops only when no
+worker has a node with f < incumbent left and no message is in flight,
+so no cheaper goal can exist anywhere.
+
+Termination uses one counter, pending = active workers + batches in
+flight. A batch is counted before it is pushed and uncounted after its
+nodes are in the receiver's open list; an idle worker that receives a
+batch counts itself active again before uncounting the batch. pending
+therefore reaches zero only when everything is done, and then stays zero.
+*/
+
+#include <vector>
+#include <utility>
+#include <queue>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+using namespace std;
+
+struct HDAStats
+{
+    long long expanded = 0;
+    long long generated = 0;
+    long long messages = 0; // nodes sent to another worker
+    long long batches = 0;
+};
+
+template <typename Problem>
+class HDAStar
+{
+public:
+    typedef typename Problem::State State;
+    typedef typename Problem::Cost Cost;
+
+    struct Result
+    {
+        bool found = false;
+        Cost cost = Cost();
+        vector<State> path; // start ... goal
+    };
+
+    HDAStar(int numThreads = max(1u, thread::hardware_concurrency()), size_t batchSize = 64)
+        : numThreads(max(1, numThreads)), batchSize(max<size_t>(1, batchSize))
+    {
+    }
+
+    Result findPath(const Problem &problem)
+    {
+        int P = numThreads;
+        vector<Worker> workers(P);
+        inboxes = vector<atomic<Batch *>>(P);
+        for (auto &inbox : inboxes)
+            inbox.store(nullptr, memory_order_relaxed);
+        pending.store(P, memory_order_relaxed);
+        incumbent.store(INF, memory_order_relaxed);
+        goalOwner = -1;
+
+        for (Worker &w : workers)
+        {
+            w.closed = unordered_map<State, Info, Hasher>(1024, Hasher{&problem});
+            w.outbox.assign(P, {});
+        }
+
+        State start = problem.start();
+        workers[owner(problem, start)].insert(start, start, 0, problem.heuristic(start));
+
+        vector<thread> threads;
+        for (int id = 0; id < P; ++id)
+            threads.emplace_back([&, id]()
+                                 { run(problem, workers, id); });
+        for (thread &t : threads)
+            t.join();
+
+        stats = HDAStats();
+        for (Worker &w : workers)
+        {
+            stats.expanded += w.stats.expanded;
+            stats.generated += w.stats.generated;
+            stats.messages += w.stats.messages;
+            stats.batches += w.stats.batches;
+        }
+
+        Result result;
+        if (goalOwner == -1)
+            return result;
+
+        // walk the parents back through the owners' closed tables
+        result.found = true;
+        result.cost = incumbent.load();
+        State curr = goalState;
+        while (true)
+        {
+            result.path.push_back(curr);
+            const Info &info = workers[owner(problem, curr)].closed.at(curr);
+            if (info.parent == curr)
+                break;
+            curr = info.parent;
+        }
+        reverse(result.path.begin(), result.path.end());
+        return result;
+    }
+
+    const HDAStats &lastStats() const
+    {
+        return stats;
+    }
+
+private:
+    static constexpr Cost INF = numeric_limits<Cost>::max();
+
+    struct Message
+    {
+        State state;
+        State parent;
+        Cost g;
+        Cost h;
+    };
+
+    struct Batch
+    {
+        vector<Message> messages;
+        Batch *next;
+    };
+
+    struct Info
+    {
+        Cost g;
+        Cost h;
+        State parent; // the start state is its own parent
+    };
+
+    struct Hasher
+    {
+        const Problem *problem;
+        size_t operator()(const State &s) const { return problem->hash(s); }
+    };
+
+    typedef pair<Cost, Cost> Key; // (f, -g): deeper nodes first on ties
+
+    // min-heap on the key alone, so State needs no operator<
+    struct ByKey
+    {
+        bool operator()(const pair<Key, State> &a, const pair<Key, State> &b) const
+        {
+            return a.first > b.first;
+        }
+    };
+
+    struct Worker
+    {
+        unordered_map<State, Info, Hasher> closed{16, Hasher{nullptr}};
+        priority_queue<pair<Key, State>, vector<pair<Key, State>>, ByKey> open;
+        vector<vector<Message>> outbox;
+        HDAStats stats;
+
+        // keeps the state only if it is new or reached with a lower g
+        void insert(const State &state, const State &parent, Cost g, Cost h)
+        {
+            auto it = closed.find(state);
+            if (it != closed.end())
+            {
+                if (it->second.g <= g)
+                    return;
+                it->second.g = g;
+                it->second.parent = parent;
+            }
+            else
+            {
+                closed.emplace(state, Info{g, h, parent});
+            }
+            open.push({{g + h, -g}, state});
+        }
+    };
+
+    int numThreads;
+    size_t batchSize;
+    vector<atomic<Batch *>> inboxes;
+    atomic<long long> pending;
+    atomic<Cost> incumbent;
+    mutex goalLock;
+    State goalState;
+    int goalOwner = -1;
+    HDAStats stats;
+
+    int owner(const Problem &problem, const State &s) const
+    {
+        // splitmix64 finaliser, so similar states spread over all workers
+        uint64_t z = problem.hash(s) + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+        return z % numThreads;
+    }
+
+    void send(Worker &w, int to)
+    {
+        if (w.outbox[to].empty())
+            return;
+
+        Batch *batch = new Batch{move(w.outbox[to]), nullptr};
+        w.outbox[to].clear();
+        w.stats.batches++;
+
+        pending.fetch_add(1, memory_order_relaxed); // counted before it is visible
+        Batch *head = inboxes[to].load(memory_order_relaxed);
+        do
+        {
+            batch->next = head;
+        } while (!inboxes[to].compare_exchange_weak(head, batch, memory_order_release, memory_order_relaxed));
+    }
+
+    void flush(Worker &w)
+    {
+        for (int to = 0; to < numThreads; ++to)
+            send(w, to);
+    }
+
+    void improveIncumbent(const State &state, Cost g, int id)
+    {
+        lock_guard<mutex> guard(goalLock);
+        if (g < incumbent.load(memory_order_relaxed))
+        {
+            goalState = state;
+            goalOwner = id;
+            incumbent.store(g, memory_order_release);
+        }
+    }
+
+    void run(const Problem &problem, vector<Worker> &workers, int id)
+    {
+        Worker &w = workers[id];
+        bool active = true;
+        vector<pair<State, Cost>> succ;
+        int sinceFlush = 0;
+
+        while (true)
+        {
+            Batch *batch = inboxes[id].exchange(nullptr, memory_order_acquire);
+            if (batch != nullptr)
+            {
+                if (!active)
+                {
+                    pending.fetch_add(1, memory_order_relaxed);
+                    active = true;
+                }
+                int received = 0;
+                while (batch != nullptr)
+                {
+                    for (const Message &m : batch->messages)
+                        w.insert(m.state, m.parent, m.g, m.h);
+                    Batch *next = batch->next;
+                    delete batch;
+                    batch = next;
+                    received++;
+                }
+                pending.fetch_sub(received, memory_order_acq_rel);
+            }
+
+            Cost bound = incumbent.load(memory_order_acquire);
+            if (!w.open.empty() && w.open.top().first.first < bound)
+            {
+                pair<Key, State> top = w.open.top();
+                w.open.pop();
+                const State &state = top.second;
+                Cost g = -top.first.second;
+                if (w.closed.at(state).g != g)
+                    continue; // stale entry, a cheaper copy was inserted
+
+                if (problem.isGoal(state))
+                {
+                    improveIncumbent(state, g, id);
+                    continue;
+                }
+
+                w.stats.expanded++;
+                succ.clear();
+                problem.successors(state, succ);
+                for (const auto &edge : succ)
+                {
+                    Cost g2 = g + edge.second;
+                    Cost h2 = problem.heuristic(edge.first);
+                    if (g2 + h2 >= bound)
+                        continue; // cannot beat the incumbent
+                    w.stats.generated++;
+
+                    int to = owner(problem, edge.first);
+                    if (to == id)
+                    {
+                        w.insert(edge.first, state, g2, h2);
+                        continue;
+                    }
+                    w.outbox[to].push_back(Message{edge.first, state, g2, h2});
+                    w.stats.messages++;
+                    if (w.outbox[to].size() >= batchSize)
+                        send(w, to);
+                }
+
+                // do not sit on small batches while others may be starving
+                if (++sinceFlush >= 256)
+                {
+                    flush(w);
+                    sinceFlush = 0;
+                }
+                continue;
+            }
+
+            // nothing useful left locally
+            flush(w);
+            sinceFlush = 0;
+            if (active && inboxes[id].load(memory_order_acquire) == nullptr)
+            {
+                active = false;
+                pending.fetch_sub(1, memory_order_acq_rel);
+            }
+            if (pending.load(memory_order_acquire) == 0)
+                break;
+            this_thread::yield();
+        }
+    }
+};
+
+// 4-connected grid with walls, the state is the cell index
+struct GridProblem
+{
+    typedef int State;
+    typedef int Cost;
+
+    int width, height;
+    vector<char> wall;
+    int S, T;
+
+    State start() const { return S; }
+
+    bool isGoal(const State &s) const { return s == T; }
+
+    Cost heuristic(const State &s) const
+    {
+        return abs(s % width - T % width) + abs(s / width - T / width);
+    }
+
+    void successors(const State &s, vector<pair<State, Cost>> &out) const
+    {
+        int x = s % width, y = s / width;
+        static const int dx[] = {1, -1, 0, 0}, dy[] = {0, 0, 1, -1};
+        for (int k = 0; k < 4; ++k)
+        {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height || wall[ny * width + nx])
+                continue;
+            out.push_back({ny * width + nx, 1});
+        }
+    }
+
+    size_t hash(const State &s) const { return s; }
+};
+
+int main()
+{
+    // 1000x1000 grid with walls: vertical bars with alternating gaps
+    GridProblem grid;
+    grid.width = grid.height = 1000;
+    grid.wall.assign(grid.width * grid.height, 0);
+    for (int x = 50; x < grid.width; x += 50)
+    {
+        int gap = (x / 50) % 2 ? grid.height - 5 : 5;
+        for (int y = 0; y < grid.height; ++y)
+        {
+            if (abs(y - gap) > 2)
+                grid.wall[y * grid.width + x] = 1;
+        }
+    }
+    grid.S = 0;
+    grid.T = grid.width * grid.height - 1;
+
+    for (int threads : {1, (int)max(1u, thread::hardware_concurrency())})
+    {
+        HDAStar<GridProblem> search(threads);
+        auto t0 = chrono::steady_clock::now();
+        HDAStar<GridProblem>::Result result = search.findPath(grid);
+        auto t1 = chrono::steady_clock::now();
+
+        const HDAStats &stats = search.lastStats();
+        cout << threads << " thread(s): cost " << result.cost << ", path " << result.path.size()
+             << " states, expanded " << stats.expanded << ", messages " << stats.messages << " in "
+             << stats.batches << " batches, "
+             << chrono::duration_cast<chrono::milliseconds>(t1 - t0).count() << " ms" << endl;
+    }
+
+    return 0;
+}
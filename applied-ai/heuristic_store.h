@@ -0,0 +1,227 @@
+/*
+Exact heuristic tables for frequently requested destinations
+
+For a destination T, a reverse one-to-all Dijkstra gives the true
+distance from every node to T. Used as the A* heuristic it is perfect:
+with ties broken towards deeper nodes, A* only expands the nodes of an
+optimal path.
+
+HeuristicStore keeps these tables for hot destinations (requested at
+least hotThreshold times), with the total size capped at maxBytes and
+the least recently used tables evicted first. A table is stored as
+uint16 when its largest finite distance fits, otherwise as int.
+
+Tables are handed out as shared_ptr<const DistanceTable>, so A* reads
+them by reference and an eviction never pulls a table from under a
+running search. Edges are (neigh_idx, cost) as in astar_exercise.cpp;
+the reverse graph is built once in the constructor.
+*/
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <climits>
+
+class DistanceTable
+{
+public:
+    static constexpr int UNREACHABLE = INT_MAX;
+
+    explicit DistanceTable(const std::vector<int> &dist)
+    {
+        int largest = 0;
+        for (int d : dist)
+        {
+            if (d != UNREACHABLE)
+                largest = std::max(largest, d);
+        }
+
+        if (largest < NARROW_UNREACHABLE)
+        {
+            narrow.resize(dist.size());
+            for (size_t v = 0; v < dist.size(); ++v)
+                narrow[v] = dist[v] == UNREACHABLE ? NARROW_UNREACHABLE : (uint16_t)dist[v];
+        }
+        else
+        {
+            wide = dist;
+        }
+    }
+
+    // distance from v to the destination, UNREACHABLE if there is no path
+    int operator[](int v) const
+    {
+        if (wide.empty())
+            return narrow[v] == NARROW_UNREACHABLE ? UNREACHABLE : narrow[v];
+        return wide[v];
+    }
+
+    size_t size() const
+    {
+        return wide.empty() ? narrow.size() : wide.size();
+    }
+
+    size_t memoryBytes() const
+    {
+        return narrow.capacity() * sizeof(uint16_t) + wide.capacity() * sizeof(int) + sizeof(*this);
+    }
+
+    bool isCompressed() const
+    {
+        return wide.empty();
+    }
+
+private:
+    static constexpr uint16_t NARROW_UNREACHABLE = UINT16_MAX;
+
+    std::vector<uint16_t> narrow;
+    std::vector<int> wide;
+};
+
+class HeuristicStore
+{
+public:
+    struct Stats
+    {
+        long long hits = 0;
+        long long misses = 0;
+        long long built = 0;
+        long long evictions = 0;
+    };
+
+    HeuristicStore(const std::vector<std::vector<std::pair<int, int>>> &adj, size_t maxBytes,
+                   int hotThreshold = 2)
+        : reverse(adj.size()), maxBytes(maxBytes), hotThreshold(hotThreshold)
+    {
+        for (size_t u = 0; u < adj.size(); ++u)
+        {
+            for (const std::pair<int, int> &edge : adj[u])
+                reverse[edge.first].push_back({(int)u, edge.second});
+        }
+    }
+
+    // exact table for T if it is cached or T just became hot, nullptr
+    // otherwise (the caller falls back to its own heuristic)
+    std::shared_ptr<const DistanceTable> lookup(int T)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = tables.find(T);
+            if (it != tables.end())
+            {
+                lru.splice(lru.begin(), lru, it->second.second);
+                stats.hits++;
+                return it->second.first;
+            }
+            stats.misses++;
+            if (requests.size() > MAX_COUNTED_DESTINATIONS)
+                requests.clear(); // forget cold destinations
+            if (++requests[T] < hotThreshold)
+                return nullptr;
+        }
+        return table(T);
+    }
+
+    // always returns the table, building it if needed
+    std::shared_ptr<const DistanceTable> table(int T)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = tables.find(T);
+            if (it != tables.end())
+            {
+                lru.splice(lru.begin(), lru, it->second.second);
+                return it->second.first;
+            }
+        }
+
+        // the Dijkstra runs outside the lock
+        std::shared_ptr<const DistanceTable> built = std::make_shared<DistanceTable>(reverseDijkstra(T));
+
+        std::lock_guard<std::mutex> guard(lock);
+        requests.erase(T);
+        if (tables.count(T) || built->memoryBytes() > maxBytes)
+            return built; // built twice concurrently, or too big to keep
+
+        lru.push_front(T);
+        tables.emplace(T, std::make_pair(built, lru.begin()));
+        usedBytes += built->memoryBytes();
+        stats.built++;
+
+        while (usedBytes > maxBytes)
+        {
+            int victim = lru.back();
+            lru.pop_back();
+            usedBytes -= tables.at(victim).first->memoryBytes();
+            tables.erase(victim);
+            stats.evictions++;
+        }
+        return built;
+    }
+
+    Stats lastStats()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+    size_t bytesUsed()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return usedBytes;
+    }
+
+private:
+    static const size_t MAX_COUNTED_DESTINATIONS = 1 << 16;
+
+    std::vector<std::vector<std::pair<int, int>>> reverse; // edges into each node
+    std::mutex lock;
+    size_t maxBytes;
+    int hotThreshold;
+    size_t usedBytes = 0;
+    Stats stats;
+
+    std::list<int> lru; // most recent first
+    std::unordered_map<int, std::pair<std::shared_ptr<const DistanceTable>, std::list<int>::iterator>> tables;
+    std::unordered_map<int, int> requests;
+
+    // one-to-all Dijkstra on the reverse graph: dist[v] is the cost v -> T
+    std::vector<int> reverseDijkstra(int T) const
+    {
+        int n = reverse.size();
+        std::vector<int> dist(n, DistanceTable::UNREACHABLE);
+        std::vector<bool> visited(n, 0);
+        std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> pq;
+
+        dist[T] = 0;
+        pq.push({0, T});
+        while (!pq.empty())
+        {
+            int u = pq.top().second;
+            pq.pop();
+            if (visited[u])
+                continue;
+            visited[u] = true;
+
+            for (const std::pair<int, int> &edge : reverse[u])
+            {
+                int v = edge.first;
+                if (!visited[v] && dist[u] + edge.second < dist[v])
+                {
+                    dist[v] = dist[u] + edge.second;
+                    pq.push({dist[v], v});
+                }
+            }
+        }
+        return dist;
+    }
+};
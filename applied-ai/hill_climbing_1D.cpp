@@ -6,6 +6,9 @@ Simple implementation of the Hill Climbing algorithm in 1D
 #include <cmath>
 #include <random>
 #include <iostream>
+#include <utility>
+
+#include "multi_start.h"
 
 using namespace std;
 
@@ -65,15 +68,27 @@ int main()
     HC1D solver;
     int num_tests = 5;
 
-    random_device dev;
-    mt19937 rng(dev());
-    uniform_int_distribution<mt19937::result_type> dist(-100, 100);
-    for (size_t i = 0; i < num_tests; ++i)
+    // restarts run in parallel, each from a start drawn with its own seed;
+    // the fixed master seed makes them repeatable
+    const uint64_t MASTER_SEED = 2024;
+    auto restart = [&](int, uint64_t seed)
     {
+        mt19937_64 rng(seed);
+        uniform_int_distribution<int> dist(-100, 100);
         int s0 = dist(rng);
-        cout << "Starting from: " << s0 << endl;
-        Solution sol = solver.solve(s0, F, 2, 0, 100);
-        cout << "Found solution: " << endl;
-        cout << "x = " << sol.s << ", f(x) = " << sol.f_val << (sol.converged ? ", converged" : ", not-converged") << endl;
-    }
-}
\ No newline at end of file
+        return make_pair(s0, solver.solve(s0, F, 2, 0, 100));
+    };
+    auto cost = [](const pair<int, Solution> &run)
+    {
+        return -(double)run.second.f_val; // maximising f
+    };
+
+    multistart::Outcome<pair<int, Solution>> outcome = multistart::solve(num_tests, MASTER_SEED, restart, cost);
+    for (int i = 0; i < num_tests; ++i)
+        cout << "Run " << i << ": f(x) = " << -outcome.costs[i] << endl;
+
+    auto &[s0, sol] = outcome.best;
+    cout << "Best run " << outcome.bestRun << " started from: " << s0 << endl;
+    cout << "Found solution: " << endl;
+    cout << "x = " << sol.s << ", f(x) = " << sol.f_val << (sol.converged ? ", converged" : ", not-converged") << endl;
+}
@@ -5,34 +5,31 @@ with the Travelling Salesman example from unit 3.2.2
 
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <cmath>
 #include <random>
 #include <algorithm>
 #include <iostream>
+#include <thread>
 #include <limits.h>
 
+#include "csv_loader.h"
+
 using namespace std;
 
-vector<vector<int>> loadMatrix(string filename, int n)
+// false unless the file holds exactly n rows of n numbers; a short or
+// non-numeric row would shift every row after it, so it fails the load
+bool loadMatrix(const string &filename, int n, vector<vector<int>> &matrix)
 {
-    vector<vector<int>> matrix(n, vector<int>(n));
-    ifstream file(filename);
-    string line;
-    int row = 0;
-    while (getline(file, line) && row < n)
+    vector<int> values;
+    if (!csv::loadRows(filename, n, values, thread::hardware_concurrency()) || values.size() != (size_t)n * n)
+        return false;
+
+    matrix.assign(n, vector<int>(n));
+    for (int row = 0; row < n; ++row)
     {
-        stringstream ss(line);
-        string val;
-        int col = 0;
-        while (getline(ss, val, ',') && col < n)
-        {
-            matrix[row][col] = stoi(val);
-            col++;
-        }
-        row++;
+        copy(values.begin() + row * n, values.begin() + (row + 1) * n, matrix[row].begin());
     }
-    return matrix;
+    return true;
 }
 
 struct Solution
@@ -101,7 +98,12 @@ int main()
 {
     int n = 50;
     string filename = "TSP Matrix.txt";
-    auto distances = loadMatrix(filename, n);
+    vector<vector<int>> distances;
+    if (!loadMatrix(filename, n, distances))
+    {
+        cerr << "Cannot load a " << n << "x" << n << " matrix from " << filename << endl;
+        return 1;
+    }
 
     auto F = [&](const vector<int> &path)
     {
@@ -13,6 +13,9 @@ they don't cross anymore.
 #include <iostream>
 #include <limits.h>
 
+#include "tsp_moves.h"
+#include "tsp_local_search.h"
+
 using namespace std;
 
 struct Solution
@@ -25,41 +28,41 @@ struct Solution
 class HC
 {
 public:
-    template <typename F>
-    Solution solve(const vector<int> start, F f, int eps, int maxIter)
+    // f is the tour length and d(u, v) the distance between two cities:
+    // moves are priced from their endpoints (tsp_moves.h), not by f.
+    // moves picks random 2-opt, Or-opt or both; LIN_KERNIGHAN instead runs
+    // the LK local search (tsp_local_search.h) to a local optimum. Tour is
+    // the representation from tour.h; the same seed gives the same run
+    template <typename Tour = tsp::ArrayTour, typename F, typename D>
+    Solution solve(const vector<int> start, F f, D d, int eps, int maxIter,
+                   tsp::Neighbourhood moves = tsp::TWO_OPT, uint64_t seed = random_device{}())
     {
         int n = start.size();
-        vector<int> sol = start;
+        if (moves == tsp::LIN_KERNIGHAN)
+        {
+            vector<int> sol = start;
+            tsp::CandidateLists cand(n, d, 8);
+            tsp::LocalSearch<D, Tour> search(cand, d, moves);
+            search.optimise(sol);
+            return Solution{sol, f(sol), true};
+        }
+
+        Tour sol(start);
         int iter = 0;
-        int best_val = f(sol);
+        int best_val = f(start);
         int noUpdate = 0;
 
-        int local_best_val = INT_MAX; // initialise the curr cost to infinite
-
-        random_device dev;
-        mt19937 rng(dev());
-        uniform_int_distribution<int> dist(0, start.size() - 1);
+        mt19937_64 rng(seed);
 
         while (iter < maxIter && noUpdate <= (int)maxIter / 3)
         {
-            // 2-opt
-            int idx1 = dist(rng);
-            int idx2 = dist(rng);
-            if (idx1 == idx2)
-                continue;
+            tsp::Move move = tsp::randomMove(sol, moves, rng);
+            int delta = tsp::moveDelta(sol, move, d);
 
-            if (idx1 > idx2)
-                swap(idx1, idx2);
-
-            vector<int> test_sol = sol;
-            reverse(test_sol.begin() + idx1, test_sol.begin() + idx2 + 1);
-
-            int local_val = (int)f(test_sol);
-
-            if (local_val - best_val <= eps)
+            if (delta <= eps)
             {
-                sol = test_sol;
-                best_val = local_val; // update the best cost
+                tsp::applyMove(sol, move);
+                best_val += delta; // update the best cost
                 noUpdate = 0;
             }
             else
@@ -71,13 +74,21 @@ public:
         }
 
         return Solution{
-            sol,
+            sol.order(),
             best_val, noUpdate < (int)maxIter / 3};
     }
 };
 
-int main()
+// ./hill_climbing_TSP_2opt [2opt|oropt|or2opt|lk] picks the neighbourhood
+int main(int argc, char **argv)
 {
+    tsp::Neighbourhood moves = tsp::TWO_OPT;
+    if (argc > 1 && !tsp::parseNeighbourhood(argv[1], moves))
+    {
+        cerr << "Unknown neighbourhood: " << argv[1] << endl;
+        return 1;
+    }
+
     int numCities = 8;
     vector<vector<int>> distances;
     distances.push_back({1, 3, 2, 2, 3, 5, 2});
@@ -89,24 +100,19 @@ int main()
     distances.push_back({1});
     distances.push_back({});
 
-    auto F = [&](const vector<int> &path)
+    auto D = [&](int u, int v)
     {
-        int totDist = 0;
-        int n = path.size();
+        if (u == v)
+            return 0;
+        int startNode = min(u, v);
+        int endNode = max(u, v);
 
-        for (size_t i = 0; i < n; ++i)
-        {
-            int u = path[i];
-            int v = path[(i + 1) % n];
-            if (u == v)
-                continue;
-            int startNode = min(u, v);
-            int endNode = max(u, v);
-
-            totDist += distances[startNode][endNode - startNode - 1];
-        }
+        return distances[startNode][endNode - startNode - 1];
+    };
 
-        return totDist;
+    auto F = [&](const vector<int> &path)
+    {
+        return tsp::tourLength(path, D);
     };
 
     HC solver;
@@ -124,7 +130,7 @@ int main()
     cout << cities[0] << endl;
     cout << "Initial cost: " << F(cities) << endl;
 
-    Solution sol = solver.solve(cities, F, 0, 1000);
+    Solution sol = solver.solve(cities, F, D, 0, 1000, moves);
     cout << "Found solution after 1000 iters: " << endl;
     for (auto const &x : sol.s)
         cout << x << "->";
@@ -9,10 +9,27 @@ deterministic approach
 #include <random>
 #include <algorithm>
 #include <iostream>
-#include <sstream>
+#include <thread>
 #include <fstream>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <stdexcept>
 #include <limits.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "csv_loader.h"
+#include "dist_matrix.h"
+#include "dist_oracle.h"
+#include "tsp_moves.h"
+#include "tsp_local_search.h"
+#include "tsp_construct.h"
+#include "multi_start.h"
+
 using namespace std;
 
 struct Point
@@ -31,50 +48,18 @@ struct Solution
 
 vector<Point> loadCoords(string filename)
 {
-    vector<Point> matrix;
-    ifstream file(filename);
-    string line;
     vector<double> coords;
+    csv::loadRows(filename, 2, coords, thread::hardware_concurrency());
 
-    while (getline(file, line))
+    vector<Point> matrix(coords.size() / 2);
+    for (size_t i = 0; i < matrix.size(); ++i)
     {
-        coords.clear();
-        string word;
-        istringstream iss(line);
-        int col = 0;
-        while (col < 2)
-        {
-            getline(iss, word, ',');
-            coords.push_back(stod(word));
-            col++;
-        }
-        if (coords.size() == 2)
-        {
-            matrix.push_back({coords[0], coords[1]});
-        }
+        matrix[i] = {coords[2 * i], coords[2 * i + 1]};
     }
 
     return matrix;
 }
 
-template <typename Distance>
-vector<vector<double>> calcDist(const vector<Point> &coords, Distance d)
-{
-    int n = coords.size();
-    vector<vector<double>> distMat;
-    for (size_t i = 0; i < n; ++i)
-    {
-        vector<double> citydist;
-        for (size_t j = i + 1; j < n; ++j)
-        {
-            citydist.push_back(d(coords[i], coords[j]));
-        }
-        distMat.push_back(citydist);
-    }
-
-    return distMat;
-}
-
 void savePath(const string &filename, const vector<int> &path, const vector<Point> &coords)
 {
     ofstream outFile(filename);
@@ -96,6 +81,13 @@ void savePath(const string &filename, const vector<int> &path, const vector<Poin
     outFile.close();
 }
 
+// neighbourhoods of HC::solveSteepest
+enum SteepestMove
+{
+    SWAP,
+    TWO_OPT
+};
+
 class HC
 {
 public:
@@ -147,21 +139,344 @@ public:
             sol,
             best_val, !improved || iter >= maxIter};
     }
+
+    // 2-opt + Or-opt (or LK with moves = LIN_KERNIGHAN) restricted to the
+    // k nearest neighbours of every city, with don't-look bits
+    // (tsp_local_search.h). Runs to a local optimum of the neighbourhood,
+    // which takes seconds on 100k cities. Tour is the representation from
+    // tour.h: TwoLevelTour keeps LK's flips cheap on large instances.
+    template <typename Tour = tsp::ArrayTour, typename F, typename D>
+    Solution<double> localSearch(const vector<int> start, F f, D d, const tsp::CandidateLists &cand,
+                                 tsp::Neighbourhood moves = tsp::OR_2OPT)
+    {
+        vector<int> sol = start;
+        tsp::LocalSearch<D, Tour> search(cand, d, moves);
+        search.optimise(sol);
+
+        return Solution<double>{
+            sol,
+            f(sol), true};
+    }
+
+    // Best-improvement descent like solve, over all swaps or all 2-opt
+    // moves, but every step prices the whole neighbourhood from move
+    // deltas instead of tour lengths: rows i are dealt to threads, the
+    // loop over j gathers d(., tour[j]) from rows of the distance matrix
+    // (four at a time with AVX2, -mavx2) and the per-thread best moves are
+    // reduced. Ties go to the lowest (i, j), so the descent is the same
+    // for any number of threads. dist must use the FULL layout, anything
+    // else throws invalid_argument.
+    template <typename F>
+    Solution<double> solveSteepest(const vector<int> start, F f, const DistMatrix &dist, SteepestMove moves,
+                                   double eps, int maxIter,
+                                   int numThreads = max(1u, thread::hardware_concurrency()))
+    {
+        vector<int> sol = start;
+        int iter = 0;
+        bool improved = true;
+
+        while (iter < maxIter && improved)
+        {
+            BestMove best = bestMove(sol, dist, moves, numThreads);
+            improved = best.delta < -eps;
+            if (improved)
+            {
+                if (moves == SWAP)
+                    swap(sol[best.i], sol[best.j]);
+                else
+                    tsp::applyTwoOpt(sol, best.i, best.j);
+            }
+            iter++;
+        }
+
+        return Solution<double>{
+            sol,
+            f(sol), !improved};
+    }
+
+    // the best move of the neighbourhood, with its delta (+inf if none)
+    struct BestMove
+    {
+        double delta = numeric_limits<double>::infinity();
+        int i = -1, j = -1;
+
+        bool betterThan(const BestMove &other) const
+        {
+            if (delta != other.delta)
+                return delta < other.delta;
+            return i < other.i || (i == other.i && j < other.j);
+        }
+    };
+
+    BestMove bestMove(const vector<int> &tour, const DistMatrix &dist, SteepestMove moves, int numThreads)
+    {
+        if (!dist.hasRows())
+            throw invalid_argument("bestMove needs a DistMatrix with the FULL layout");
+        int n = tour.size();
+        if (n < 4)
+            return BestMove{};
+
+        // succ[j] = tour[j + 1], pred[j] = tour[j - 1], edge[j] the length of
+        // (tour[j], succ[j]) and around[j] = edge[j - 1] + edge[j], so the
+        // inner loops read contiguous arrays
+        Neighbours nb{vector<int>(n), vector<int>(n), vector<double>(n), vector<double>(n)};
+        for (int j = 0; j < n; ++j)
+        {
+            nb.succ[j] = tour[(j + 1) % n];
+            nb.pred[j] = tour[(j + n - 1) % n];
+            nb.edge[j] = dist(tour[j], nb.succ[j]);
+        }
+        for (int j = 0; j < n; ++j)
+            nb.around[j] = nb.edge[(j + n - 1) % n] + nb.edge[j];
+
+        numThreads = max(1, min(numThreads, n / 64 + 1));
+        vector<BestMove> found(numThreads);
+        auto worker = [&](int t)
+        {
+            for (int i = t; i < n - 1; i += numThreads)
+            {
+                BestMove m = moves == SWAP ? bestSwap(tour, nb, dist, i) : bestTwoOpt(tour, nb, dist, i);
+                if (m.betterThan(found[t]))
+                    found[t] = m;
+            }
+        };
+
+        vector<thread> workers;
+        for (int t = 1; t < numThreads; ++t)
+            workers.emplace_back(worker, t);
+        worker(0);
+        for (thread &w : workers)
+            w.join();
+
+        BestMove best;
+        for (const BestMove &m : found)
+            if (m.betterThan(best))
+                best = m;
+        return best;
+    }
+
+private:
+    struct Neighbours
+    {
+        vector<int> succ, pred;
+        vector<double> edge, around;
+    };
+
+    // min over j in [from, to] of rows[0][idx[0][j]] + ... + rows[K-1][idx[K-1][j]]
+    // - sub[j], ties to the lowest j; returns (value, j), j = -1 if empty
+    template <int K>
+    static pair<double, int> scanRow(const double *const (&rows)[K], const int *const (&idx)[K],
+                                     const double *sub, int from, int to)
+    {
+        double bestValue = numeric_limits<double>::infinity();
+        int bestJ = -1;
+        int j = from;
+#if defined(__AVX2__)
+        __m256d bestV = _mm256_set1_pd(bestValue);
+        __m256d bestIdx = _mm256_set1_pd(-1.0);
+        __m256d jv = _mm256_setr_pd(j, j + 1, j + 2, j + 3);
+        const __m256d four = _mm256_set1_pd(4.0);
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        for (; j + 3 <= to; j += 4)
+        {
+            __m256d v = _mm256_sub_pd(_mm256_setzero_pd(), _mm256_loadu_pd(sub + j));
+            for (int k = 0; k < K; ++k)
+            {
+                __m128i ix = _mm_loadu_si128((const __m128i *)(idx[k] + j));
+                v = _mm256_add_pd(v, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), rows[k], ix, all, 8));
+            }
+
+            // strict < keeps the first j of every lane
+            __m256d better = _mm256_cmp_pd(v, bestV, _CMP_LT_OQ);
+            bestV = _mm256_blendv_pd(bestV, v, better);
+            bestIdx = _mm256_blendv_pd(bestIdx, jv, better);
+            jv = _mm256_add_pd(jv, four);
+        }
+
+        double values[4], indices[4];
+        _mm256_storeu_pd(values, bestV);
+        _mm256_storeu_pd(indices, bestIdx);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            int lj = (int)indices[lane];
+            if (lj >= 0 && (values[lane] < bestValue || (values[lane] == bestValue && lj < bestJ)))
+            {
+                bestValue = values[lane];
+                bestJ = lj;
+            }
+        }
+#endif
+        for (; j <= to; ++j)
+        {
+            double v = -sub[j];
+            for (int k = 0; k < K; ++k)
+                v += rows[k][idx[k][j]];
+            if (v < bestValue)
+            {
+                bestValue = v;
+                bestJ = j;
+            }
+        }
+        return {bestValue, bestJ};
+    }
+
+    // reversing tour[i..j] with a = pred[i], b = tour[i]:
+    // d(a, tour[j]) + d(b, succ[j]) - edge[j] - d(a, b)
+    static BestMove bestTwoOpt(const vector<int> &tour, const Neighbours &nb, const DistMatrix &dist, int i)
+    {
+        int n = tour.size();
+        int a = nb.pred[i], b = tour[i];
+        int last = i == 0 ? n - 2 : n - 1; // reversing everything changes nothing
+
+        const double *const rows[2] = {dist.row(a), dist.row(b)};
+        const int *const idx[2] = {tour.data(), nb.succ.data()};
+        pair<double, int> m = scanRow<2>(rows, idx, nb.edge.data(), i + 1, last);
+        if (m.second < 0)
+            return BestMove{};
+        return BestMove{m.first - nb.edge[(i + n - 1) % n], i, m.second};
+    }
+
+    // swapping tour[i] = t and tour[j], j >= i + 2 and not across the end:
+    // d(p, tour[j]) + d(nx, tour[j]) + d(t, pred[j]) + d(t, succ[j])
+    // - around[j] - around[i], with p = pred[i] and nx = succ[i].
+    // Neighbouring positions (j = i + 1, and i = 0 with j = n - 1) share an
+    // edge and are priced on their own
+    static BestMove bestSwap(const vector<int> &tour, const Neighbours &nb, const DistMatrix &dist, int i)
+    {
+        int n = tour.size();
+        int t = tour[i], p = nb.pred[i], nx = nb.succ[i];
+
+        // p t nx nj -> p nx t nj
+        int nj = nb.succ[i + 1];
+        BestMove best{dist(p, nx) + dist(t, nj) - dist(p, t) - dist(nx, nj), i, i + 1};
+
+        int last = i == 0 ? n - 2 : n - 1;
+        if (i + 2 <= last)
+        {
+            const double *const rows[4] = {dist.row(p), dist.row(nx), dist.row(t), dist.row(t)};
+            const int *const idx[4] = {tour.data(), tour.data(), nb.pred.data(), nb.succ.data()};
+            pair<double, int> m = scanRow<4>(rows, idx, nb.around.data(), i + 2, last);
+            BestMove general{m.first - nb.around[i], i, m.second};
+            if (general.betterThan(best))
+                best = general;
+        }
+
+        if (i == 0)
+        {
+            // tour[n - 1] and tour[0] are neighbours across the end
+            int pj = tour[n - 2], tl = tour[n - 1];
+            BestMove wrap{dist(pj, t) + dist(tl, nx) - dist(pj, tl) - dist(t, nx), 0, n - 1};
+            if (wrap.betterThan(best))
+                best = wrap;
+        }
+        return best;
+    }
 };
 
-int main()
+// ./hill_climbing_TSP_steepest <n> [2opt|oropt|or2opt|lk] [array|twolevel]
+// [random|nn|greedy|sfc|christofides] runs the candidate-list local search
+// on n random cities instead, where an n x n matrix would not fit; the last
+// argument picks the start tour, greedy by default
+void runLarge(int nCities, tsp::Neighbourhood moves, bool twoLevel, tsp::Construction start)
 {
-    string filename = "data/TSP Matrix.csv";
-    vector<Point> coordsCities = loadCoords(filename);
-    int nCities = coordsCities.size();
-
-    auto euclideanDistance = [](Point x, Point y)
+    mt19937 rng(42);
+    uniform_real_distribution<double> coord(0.0, 1000.0);
+    vector<Point> coordsCities(nCities);
+    for (Point &p : coordsCities)
+        p = {coord(rng), coord(rng)};
+
+    // distances computed on demand: 16 bytes per city instead of 8n
+    DistOracle oracle(coordsCities);
+    auto D = [&](int u, int v)
+    {
+        return oracle(u, v);
+    };
+    auto F = [&](const vector<int> &path)
     {
-        return sqrt(pow((x.X - y.X), 2) + pow((x.Y - y.Y), 2));
+        return oracle.tourLength(path);
     };
 
-    vector<vector<double>>
-        distMat = calcDist(coordsCities, euclideanDistance);
+    auto t0 = chrono::steady_clock::now();
+    tsp::CandidateLists cand(coordsCities, 8);
+    auto t1 = chrono::steady_clock::now();
+
+    vector<int> cities = tsp::initialTour(coordsCities, cand, start, rng);
+    auto t2 = chrono::steady_clock::now();
+    cout << "Initial cost: " << F(cities) << endl;
+
+    HC solver;
+    Solution<double> sol = twoLevel ? solver.localSearch<tsp::TwoLevelTour>(cities, F, D, cand, moves)
+                                    : solver.localSearch(cities, F, D, cand, moves);
+    auto t3 = chrono::steady_clock::now();
+
+    cout << "Final cost = " << sol.f_val << endl;
+    cout << "Candidate lists: " << chrono::duration<double>(t1 - t0).count() << " s, "
+         << "start tour: " << chrono::duration<double>(t2 - t1).count() << " s, "
+         << "local search: " << chrono::duration<double>(t3 - t2).count() << " s" << endl;
+}
+
+// ./hill_climbing_TSP_steepest <n> steepest times one best-improvement
+// step over all swaps and all 2-opt moves on n random cities, on one
+// thread and on all of them
+void runSteepestStep(int nCities)
+{
+    mt19937 rng(42);
+    uniform_real_distribution<double> coord(0.0, 1000.0);
+    vector<Point> coordsCities(nCities);
+    for (Point &p : coordsCities)
+        p = {coord(rng), coord(rng)};
+    DistMatrix distMat(coordsCities);
+
+    vector<int> cities(nCities);
+    iota(cities.begin(), cities.end(), 0);
+    shuffle(begin(cities), end(cities), rng);
+
+    HC solver;
+    int threads = max(1u, thread::hardware_concurrency());
+    for (SteepestMove moves : {SWAP, TWO_OPT})
+    {
+        for (int numThreads : {1, threads})
+        {
+            auto t0 = chrono::steady_clock::now();
+            HC::BestMove best = solver.bestMove(cities, distMat, moves, numThreads);
+            auto t1 = chrono::steady_clock::now();
+            cout << (moves == SWAP ? "swap" : "2-opt") << ", " << numThreads << " thread(s): best delta "
+                 << best.delta << " at (" << best.i << ", " << best.j << ") in "
+                 << chrono::duration<double>(t1 - t0).count() << " s" << endl;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2 && string(argv[2]) == "steepest")
+    {
+        runSteepestStep(atoi(argv[1]));
+        return 0;
+    }
+    if (argc > 1)
+    {
+        tsp::Neighbourhood moves = tsp::OR_2OPT;
+        if (argc > 2 && !tsp::parseNeighbourhood(argv[2], moves))
+        {
+            cerr << "Unknown neighbourhood: " << argv[2] << endl;
+            return 1;
+        }
+        tsp::Construction start = tsp::GREEDY_EDGE;
+        if (argc > 4 && !tsp::parseConstruction(argv[4], start))
+        {
+            cerr << "Unknown start tour: " << argv[4] << endl;
+            return 1;
+        }
+        runLarge(atoi(argv[1]), moves, !(argc > 3 && string(argv[3]) == "array"), start);
+        return 0;
+    }
+
+    string filename = "data/TSP Matrix.csv";
+    vector<Point> coordsCities = loadCoords(filename);
+
+    // Euclidean distances, computed once
+    DistMatrix distMat(coordsCities);
 
     auto F = [&](const vector<int> &path) -> double
     {
@@ -170,56 +485,76 @@ int main()
 
         for (size_t i = 0; i < n; ++i)
         {
-            int u = path[i];
-            int v = path[(i + 1) % n];
-            if (u == v)
-                continue;
-            int startNode = min(u, v);
-            int endNode = max(u, v);
-
-            totDist += distMat[startNode][endNode - startNode - 1];
+            totDist += distMat(path[i], path[(i + 1) % n]);
         }
 
         return totDist;
     };
+    auto D = [&](int u, int v)
+    {
+        return distMat(u, v);
+    };
+    tsp::CandidateLists cand(coordsCities, 8);
 
     HC solver;
     int num_tests = 5;
 
-    double bestCost = 99999999999.9;
-
-    for (size_t t = 0; t < num_tests; ++t)
+    // one restart: a nearest-neighbour tour from a city picked by the
+    // multi-start driver's seed, then the swap hill climber and the
+    // candidate-list local searches
+    struct Restart
     {
-        // Initialise the vector of cities IDs
-        vector<int> cities(nCities);
-        iota(cities.begin(), cities.end(), 0);
-
-        random_device dev;
-        mt19937 rng(dev());
-
-        // start from random path
-        shuffle(begin(cities), end(cities), rng);
-        cout << "Starting path: " << endl;
-        for (auto const &x : cities)
-            cout << x << "->";
-        cout << cities[0] << endl;
-        cout << "Initial cost: " << F(cities) << endl;
-
-        Solution sol = solver.solve(cities, F, 0.0, 5000);
-        cout << "Found solution after 1000 iters: " << endl;
-        for (auto const &x : sol.s)
-            cout << x << "->";
-        cout << sol.s[0] << endl;
-        cout << "Final cost = " << sol.f_val << endl;
-        cout << (sol.converged ? "Converged" : "Not-converged") << endl;
+        vector<int> start;
+        Solution<double> swaps, steepest2opt, local, lk;
+        Solution<double> best;
+    };
+    auto restart = [&](int, uint64_t seed)
+    {
+        Restart r;
+        mt19937_64 rng(seed);
+        r.start = tsp::initialTour(coordsCities, cand, tsp::NEAREST_NEIGHBOUR, rng);
+
+        r.swaps = solver.solve(r.start, F, 0.0, 5000);
+        // one thread each: the restarts already fill the cores
+        r.steepest2opt = solver.solveSteepest(r.start, F, distMat, TWO_OPT, 1e-9, 5000, 1);
+        r.local = solver.localSearch(r.start, F, D, cand);
+        r.lk = solver.localSearch(r.start, F, D, cand, tsp::LIN_KERNIGHAN);
+        r.best = r.swaps;
+        for (const Solution<double> &sol : {r.steepest2opt, r.local, r.lk})
+            if (sol.f_val < r.best.f_val)
+                r.best = sol;
+        return r;
+    };
+    auto cost = [](const Restart &r)
+    {
+        return r.best.f_val;
+    };
 
-        if (sol.f_val < bestCost)
-        {
-            bestCost = sol.f_val;
-            // write the initial solution
-            savePath("results/path_initial.csv", cities, coordsCities);
-            // write the found solution
-            savePath("results/path_final.csv", sol.s, coordsCities);
-        }
-    }
-}
\ No newline at end of file
+    // restarts run in parallel; the fixed master seed makes them repeatable
+    const uint64_t MASTER_SEED = 2024;
+    multistart::Outcome<Restart> outcome = multistart::solve(num_tests, MASTER_SEED, restart, cost);
+    for (int t = 0; t < num_tests; ++t)
+        cout << "Run " << t << ": cost " << outcome.costs[t] << endl;
+
+    const Restart &best = outcome.best;
+    cout << "Best run: " << outcome.bestRun << " (seed " << outcome.bestSeed << ")" << endl;
+    cout << "Starting path: " << endl;
+    for (auto const &x : best.start)
+        cout << x << "->";
+    cout << best.start[0] << endl;
+    cout << "Initial cost: " << F(best.start) << endl;
+    cout << "Swap hill climbing: " << best.swaps.f_val
+         << (best.swaps.converged ? " (converged)" : " (not converged)") << endl;
+    cout << "Steepest 2-opt: " << best.steepest2opt.f_val << endl;
+    cout << "2-opt + Or-opt with candidate lists: " << best.local.f_val << endl;
+    cout << "Lin-Kernighan with candidate lists: " << best.lk.f_val << endl;
+    cout << "Found solution: " << endl;
+    for (auto const &x : best.best.s)
+        cout << x << "->";
+    cout << best.best.s[0] << endl;
+    cout << "Final cost = " << best.best.f_val << endl;
+
+    // write the initial and the found solution
+    savePath("results/path_initial.csv", best.start, coordsCities);
+    savePath("results/path_final.csv", best.best.s, coordsCities);
+}
@@ -0,0 +1,84 @@
+/*
+A*, IDA* and IDS on the 8- and 15-puzzle without building adj (see
+implicit_search.h)
+*/
+
+#include <vector>
+#include <utility>
+#include <random>
+#include <chrono>
+#include <iostream>
+
+#include "implicit_search.h"
+
+using namespace std;
+
+// scrambles the goal with random moves, so the instance is solvable
+template <int Side>
+vector<int> randomWalk(int moves, unsigned seed)
+{
+    typedef SlidingTilePuzzle<Side> Puzzle;
+    vector<int> tiles(Puzzle::CELLS);
+    for (int cell = 0; cell < Puzzle::CELLS; ++cell)
+        tiles[cell] = cell;
+
+    Puzzle puzzle(tiles);
+    typename Puzzle::State state = puzzle.start();
+    mt19937 rng(seed);
+    vector<pair<typename Puzzle::State, int>> succ;
+    for (int i = 0; i < moves; ++i)
+    {
+        succ.clear();
+        puzzle.successors(state, succ);
+        state = succ[rng() % succ.size()].first;
+    }
+
+    for (int cell = 0; cell < Puzzle::CELLS; ++cell)
+        tiles[cell] = state.get(cell);
+    return tiles;
+}
+
+template <typename Search, typename Problem, typename... Args>
+void report(const char *name, Search &search, const Problem &problem, Args... args)
+{
+    auto t0 = chrono::steady_clock::now();
+    auto result = search.findPath(problem, args...);
+    auto t1 = chrono::steady_clock::now();
+
+    cout << name << ": ";
+    if (!result.found)
+        cout << "no solution";
+    else
+        cout << result.cost << " moves";
+    cout << ", expanded " << search.lastStats().expanded << ", "
+         << chrono::duration_cast<chrono::milliseconds>(t1 - t0).count() << " ms" << endl;
+}
+
+int main()
+{
+    // 8-puzzle
+    SlidingTilePuzzle<3> eight({7, 2, 4, 5, 0, 6, 8, 3, 1});
+    cout << "8-puzzle " << SlidingTilePuzzle<3>::toString(eight.start()) << endl;
+
+    ImplicitAStar<SlidingTilePuzzle<3>> astar8;
+    ImplicitIDAStar<SlidingTilePuzzle<3>> idastar8;
+    report("  A*  ", astar8, eight);
+    report("  IDA*", idastar8, eight);
+
+    SlidingTilePuzzle<3> shallow(randomWalk<3>(12, 1));
+    ImplicitIDS<SlidingTilePuzzle<3>> ids8;
+    cout << "8-puzzle " << SlidingTilePuzzle<3>::toString(shallow.start()) << endl;
+    report("  IDS ", ids8, shallow, 20);
+    report("  A*  ", astar8, shallow);
+
+    // 15-puzzle, 4 bits per tile: one board is a single uint64
+    SlidingTilePuzzle<4> fifteen(randomWalk<4>(200, 7));
+    cout << "15-puzzle " << SlidingTilePuzzle<4>::toString(fifteen.start()) << endl;
+
+    ImplicitAStar<SlidingTilePuzzle<4>> astar15;
+    ImplicitIDAStar<SlidingTilePuzzle<4>> idastar15;
+    report("  A*  ", astar15, fifteen);
+    report("  IDA*", idastar15, fifteen);
+
+    return 0;
+}
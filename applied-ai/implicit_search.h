@@ -0,0 +1,299 @@
+/*
+A*, IDA* and IDS over implicit state spaces
+
+The same algorithms as astar.cpp, idastar.cpp and ids_template.cpp, but
+templated on a Problem (see state_space.h) instead of reading adj: the
+successors of a state are generated when it is expanded, and states are
+kept packed (one uint64 for a 15-puzzle board) in open-addressing
+StateTables.
+
+  ImplicitAStar    open list + closed StateTable<State, record index>
+  ImplicitIDAStar  depth-first, memory is only the current path
+  ImplicitIDS      unit-cost iterative deepening, a StateTable keeps the
+                   best remaining depth per state, like visitedAtLimit in
+                   ids_template.cpp
+
+The demo is in implicit_search.cpp.
+*/
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <queue>
+#include <tuple>
+#include <limits>
+#include <algorithm>
+
+#include "state_space.h"
+
+struct SearchStats
+{
+    long long expanded = 0;
+    long long generated = 0;
+};
+
+template <typename State, typename Cost>
+struct SearchResult
+{
+    bool found = false;
+    Cost cost = Cost();
+    std::vector<State> path; // start ... goal
+};
+
+template <typename Problem>
+class ImplicitAStar
+{
+public:
+    typedef typename Problem::State State;
+    typedef typename Problem::Cost Cost;
+    typedef SearchResult<State, Cost> Result;
+
+    Result findPath(const Problem &problem)
+    {
+        stats = SearchStats();
+        records.clear();
+        StateTable<State, int> closed; // state -> index in records
+
+        typedef std::tuple<Cost, Cost, int> Entry; // (f, -g, record): deeper first on ties
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+
+        State start = problem.start();
+        records.push_back({start, -1, 0, false});
+        closed.insert(start, 0);
+        pq.push(std::make_tuple(problem.heuristic(start), 0, 0));
+
+        std::vector<std::pair<State, Cost>> succ;
+        while (!pq.empty())
+        {
+            int idx = std::get<2>(pq.top());
+            Cost g = -std::get<1>(pq.top());
+            pq.pop();
+            if (records[idx].expanded || records[idx].g != g)
+                continue; // we skip those rubbish nodes with higher costs
+
+            records[idx].expanded = true;
+            State state = records[idx].state;
+            if (problem.isGoal(state))
+                return buildResult(idx);
+
+            stats.expanded++;
+            succ.clear();
+            problem.successors(state, succ);
+            for (const std::pair<State, Cost> &edge : succ)
+            {
+                Cost newG = g + edge.second;
+                std::pair<int *, bool> slot = closed.insert(edge.first, (int)records.size());
+                if (slot.second)
+                {
+                    records.push_back({edge.first, idx, newG, false});
+                }
+                else
+                {
+                    Record &known = records[*slot.first];
+                    if (known.g <= newG)
+                        continue;
+                    // cheaper path found: re-open it
+                    known.parent = idx;
+                    known.g = newG;
+                    known.expanded = false;
+                }
+                stats.generated++;
+                pq.push(std::make_tuple(newG + problem.heuristic(edge.first), -newG, *closed.find(edge.first)));
+            }
+        }
+        return Result();
+    }
+
+    const SearchStats &lastStats() const
+    {
+        return stats;
+    }
+
+private:
+    struct Record
+    {
+        State state;
+        int parent;
+        Cost g;
+        bool expanded;
+    };
+
+    std::vector<Record> records;
+    SearchStats stats;
+
+    Result buildResult(int idx)
+    {
+        Result result;
+        result.found = true;
+        result.cost = records[idx].g;
+        for (int curr = idx; curr != -1; curr = records[curr].parent)
+            result.path.push_back(records[curr].state);
+        std::reverse(result.path.begin(), result.path.end());
+        return result;
+    }
+};
+
+enum Outcome
+{
+    EXCEEDED,
+    FOUND,
+    NOT_FOUND
+};
+
+template <typename Problem>
+class ImplicitIDAStar
+{
+public:
+    typedef typename Problem::State State;
+    typedef typename Problem::Cost Cost;
+    typedef SearchResult<State, Cost> Result;
+
+    Result findPath(const Problem &problem)
+    {
+        stats = SearchStats();
+        path.assign(1, problem.start());
+        successors.clear();
+
+        Cost threshold = problem.heuristic(path[0]);
+        Outcome status = EXCEEDED;
+        while (status == EXCEEDED)
+        {
+            std::pair<Outcome, Cost> res = search(problem, 0, threshold);
+            status = res.first;
+            if (status == FOUND)
+            {
+                Result result;
+                result.found = true;
+                result.cost = res.second;
+                result.path = path;
+                return result;
+            }
+            threshold = res.second;
+        }
+        return Result();
+    }
+
+    const SearchStats &lastStats() const
+    {
+        return stats;
+    }
+
+private:
+    static constexpr Cost INF = std::numeric_limits<Cost>::max();
+
+    std::vector<State> path;                                     // current branch
+    std::vector<std::vector<std::pair<State, Cost>>> successors; // one buffer per depth
+    SearchStats stats;
+
+    // returns (FOUND, cost) or (EXCEEDED, smallest f above threshold)
+    std::pair<Outcome, Cost> search(const Problem &problem, Cost g, Cost threshold)
+    {
+        const State state = path.back();
+        Cost f = g + problem.heuristic(state);
+        if (f > threshold)
+            return {EXCEEDED, f};
+        if (problem.isGoal(state))
+            return {FOUND, g};
+
+        size_t depth = path.size() - 1;
+        if (successors.size() <= depth)
+            successors.resize(depth + 1);
+
+        stats.expanded++;
+        successors[depth].clear();
+        problem.successors(state, successors[depth]);
+
+        Cost minExceeded = INF;
+        for (size_t i = 0; i < successors[depth].size(); ++i)
+        {
+            std::pair<State, Cost> edge = successors[depth][i];
+            // never walk back onto the current branch
+            if (std::find(path.begin(), path.end(), edge.first) != path.end())
+                continue;
+
+            stats.generated++;
+            path.push_back(edge.first);
+            std::pair<Outcome, Cost> result = search(problem, g + edge.second, threshold);
+            if (result.first == FOUND)
+                return result;
+            path.pop_back();
+
+            if (result.first == EXCEEDED && result.second < minExceeded)
+                minExceeded = result.second;
+        }
+
+        if (minExceeded != INF)
+            return {EXCEEDED, minExceeded};
+        return {NOT_FOUND, minExceeded};
+    }
+};
+
+template <typename Problem>
+class ImplicitIDS
+{
+public:
+    typedef typename Problem::State State;
+    typedef typename Problem::Cost Cost;
+    typedef SearchResult<State, Cost> Result;
+
+    // cost is the number of moves, edge costs are ignored
+    Result findPath(const Problem &problem, int maxDepth)
+    {
+        stats = SearchStats();
+        for (int limit = 0; limit <= maxDepth; ++limit)
+        {
+            visitedAtLimit.clear();
+            path.assign(1, problem.start());
+            visitedAtLimit.insert(path[0], limit);
+
+            if (DLS(problem, limit))
+            {
+                Result result;
+                result.found = true;
+                result.cost = path.size() - 1;
+                result.path = path;
+                return result;
+            }
+        }
+        return Result();
+    }
+
+    const SearchStats &lastStats() const
+    {
+        return stats;
+    }
+
+private:
+    std::vector<State> path;
+    StateTable<State, int> visitedAtLimit;
+    SearchStats stats;
+
+    bool DLS(const Problem &problem, int limit)
+    {
+        State curr = path.back();
+        if (problem.isGoal(curr))
+            return true;
+        if (limit <= 0)
+            return false;
+
+        stats.expanded++;
+        std::vector<std::pair<State, Cost>> succ;
+        problem.successors(curr, succ);
+        for (const std::pair<State, Cost> &edge : succ)
+        {
+            std::pair<int *, bool> slot = visitedAtLimit.insert(edge.first, limit - 1);
+            bool isBetterBudget = slot.second || limit - 1 > *slot.first;
+            if (!isBetterBudget)
+                continue;
+            *slot.first = limit - 1;
+
+            stats.generated++;
+            path.push_back(edge.first);
+            if (DLS(problem, limit - 1))
+                return true;
+            path.pop_back();
+        }
+        return false;
+    }
+};
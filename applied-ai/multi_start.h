@@ -0,0 +1,169 @@
+/*
+Multi-start driver for the local search solvers
+
+Runs numRuns independent solves on a pool of threads and keeps the best:
+
+  run(i, seed)    solves restart i with its own seed and returns any result
+  cost(result)    the number to minimise (negate it to maximise)
+
+Every run's seed is splitmix64 of the master seed and the run index, so
+a run does the same work whichever thread picks it up: with the same
+master seed the costs of all runs, and the best, are the same from one
+execution to the next and for any number of threads. Ties go to the
+lower run index.
+
+The runs are dealt to per-thread queues in contiguous blocks. A thread
+takes its own runs from the front and, once out of work, steals from the
+back of the other queues, so one slow restart does not leave the other
+threads idle.
+
+If target is given, the first result with cost <= target stops the
+driver: runs already in progress finish, the ones not yet started are
+skipped (their cost is NaN). Which runs get skipped depends on timing.
+
+If run or cost throws, the driver stops the same way and rethrows the
+first exception from solve once every thread has finished.
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <cmath>
+
+namespace multistart
+{
+    inline uint64_t splitmix64(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    inline uint64_t seedFor(uint64_t masterSeed, int run)
+    {
+        return splitmix64(masterSeed + 0x9e3779b97f4a7c15ULL * (uint64_t)run);
+    }
+
+    template <typename Result>
+    struct Outcome
+    {
+        Result best{};
+        double bestCost = std::numeric_limits<double>::infinity();
+        int bestRun = -1;
+        uint64_t bestSeed = 0;
+        std::vector<double> costs; // per run, NaN if skipped
+        bool reachedTarget = false;
+    };
+
+    template <typename Run, typename Cost>
+    auto solve(int numRuns, uint64_t masterSeed, Run run, Cost cost,
+               double target = -std::numeric_limits<double>::infinity(),
+               int numThreads = std::max(1u, std::thread::hardware_concurrency()))
+        -> Outcome<decltype(run(0, uint64_t()))>
+    {
+        using Result = decltype(run(0, uint64_t()));
+
+        struct Queue
+        {
+            std::deque<int> runs;
+            std::mutex lock;
+        };
+
+        Outcome<Result> outcome;
+        outcome.costs.assign(std::max(0, numRuns), std::numeric_limits<double>::quiet_NaN());
+        numThreads = std::max(1, std::min(numThreads, numRuns));
+        if (numRuns <= 0)
+            return outcome;
+
+        std::vector<Queue> queues(numThreads);
+        for (int i = 0; i < numRuns; ++i)
+            queues[(long long)i * numThreads / numRuns].runs.push_back(i);
+
+        std::mutex bestLock;
+        std::atomic<bool> stop(false);
+        std::exception_ptr error; // the first exception, under bestLock
+
+        auto take = [&](int id, int &out)
+        {
+            {
+                std::lock_guard<std::mutex> guard(queues[id].lock);
+                if (!queues[id].runs.empty())
+                {
+                    out = queues[id].runs.front();
+                    queues[id].runs.pop_front();
+                    return true;
+                }
+            }
+            // runs are never added, so empty everywhere means done
+            for (int k = 1; k < numThreads; ++k)
+            {
+                Queue &victim = queues[(id + k) % numThreads];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (!victim.runs.empty())
+                {
+                    out = victim.runs.back();
+                    victim.runs.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        auto worker = [&](int id)
+        {
+            int i;
+            while (!stop.load(std::memory_order_relaxed) && take(id, i))
+            {
+                uint64_t seed = seedFor(masterSeed, i);
+                try
+                {
+                    Result result = run(i, seed);
+                    double c = cost(result);
+
+                    std::lock_guard<std::mutex> guard(bestLock);
+                    outcome.costs[i] = c;
+                    bool better = c < outcome.bestCost || (c == outcome.bestCost && i < outcome.bestRun);
+                    if (!std::isnan(c) && (outcome.bestRun < 0 || better))
+                    {
+                        outcome.best = std::move(result);
+                        outcome.bestCost = c;
+                        outcome.bestRun = i;
+                        outcome.bestSeed = seed;
+                    }
+                    if (c <= target)
+                    {
+                        outcome.reachedTarget = true;
+                        stop.store(true, std::memory_order_relaxed);
+                    }
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(bestLock);
+                    if (!error)
+                        error = std::current_exception();
+                    stop.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < numThreads; ++t)
+            workers.emplace_back(worker, t);
+        worker(0);
+        for (std::thread &w : workers)
+            w.join();
+
+        if (error)
+            std::rethrow_exception(error);
+        return outcome;
+    }
+}
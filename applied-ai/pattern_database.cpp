@@ -0,0 +1,90 @@
+/*
+IDA* on the 15-puzzle with an additive 5-5-5 pattern database
+
+The three tables are built once (in parallel) and saved in the temporary
+directory; later runs map them from disk instead of rebuilding them.
+*/
+
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+
+#include "implicit_search.h"
+#include "pattern_database.h"
+
+using namespace std;
+
+// scrambles the goal with random moves, so the instance is solvable
+vector<int> randomWalk(int moves, unsigned seed)
+{
+    vector<int> tiles(16);
+    for (int cell = 0; cell < 16; ++cell)
+        tiles[cell] = cell;
+
+    SlidingTilePuzzle<4> puzzle(tiles);
+    SlidingTilePuzzle<4>::State state = puzzle.start();
+    mt19937 rng(seed);
+    vector<pair<SlidingTilePuzzle<4>::State, int>> succ;
+    for (int i = 0; i < moves; ++i)
+    {
+        succ.clear();
+        puzzle.successors(state, succ);
+        state = succ[rng() % succ.size()].first;
+    }
+
+    for (int cell = 0; cell < 16; ++cell)
+        tiles[cell] = state.get(cell);
+    return tiles;
+}
+
+int main()
+{
+    vector<vector<int>> patterns = {{1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}, {11, 12, 13, 14, 15}};
+    vector<PatternDatabase<4>> pdbs(patterns.size());
+
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        string filename = (filesystem::temp_directory_path() / ("pdb15_" + to_string(i) + ".bin")).string();
+        if (pdbs[i].load(filename))
+        {
+            cout << "Mapped " << filename << endl;
+            continue;
+        }
+
+        auto t0 = chrono::steady_clock::now();
+        pdbs[i].build(patterns[i]);
+        auto t1 = chrono::steady_clock::now();
+        cout << "Built PDB " << i << ": " << pdbs[i].size() << " entries, " << pdbs[i].memoryBytes()
+             << " bytes, " << chrono::duration_cast<chrono::milliseconds>(t1 - t0).count() << " ms" << endl;
+
+        if (!pdbs[i].save(filename))
+            cerr << "Cannot save " << filename << endl;
+    }
+
+    for (unsigned seed : {1, 2})
+    {
+        vector<int> tiles = randomWalk(300, seed);
+        SlidingTilePuzzle<4> plain(tiles);
+        PDBSlidingTilePuzzle<4> strong(tiles, pdbs);
+        cout << "15-puzzle " << SlidingTilePuzzle<4>::toString(plain.start()) << endl;
+
+        ImplicitIDAStar<SlidingTilePuzzle<4>> manhattan;
+        auto t0 = chrono::steady_clock::now();
+        auto a = manhattan.findPath(plain);
+        auto t1 = chrono::steady_clock::now();
+
+        ImplicitIDAStar<PDBSlidingTilePuzzle<4>> additive;
+        auto b = additive.findPath(strong);
+        auto t2 = chrono::steady_clock::now();
+
+        cout << "  Manhattan: " << a.cost << " moves, expanded " << manhattan.lastStats().expanded << ", "
+             << chrono::duration_cast<chrono::milliseconds>(t1 - t0).count() << " ms" << endl;
+        cout << "  5-5-5 PDB: " << b.cost << " moves, expanded " << additive.lastStats().expanded << ", "
+             << chrono::duration_cast<chrono::milliseconds>(t2 - t1).count() << " ms" << endl;
+    }
+
+    return 0;
+}
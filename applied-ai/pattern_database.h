@@ -0,0 +1,465 @@
+/*
+Additive pattern databases for the sliding-tile puzzles
+
+A pattern is a subset of the tiles. The PDB stores, for every placement
+of the pattern tiles, the least number of moves of pattern tiles needed
+to bring them home (the other tiles are indistinguishable and move for
+free). Since disjoint patterns never count the same move twice, their
+values add up to an admissible heuristic, e.g. the 5-5-5 split of the
+15-puzzle.
+
+Building: a backward 0-1 BFS from the goal over the abstract states
+(blank cell, pattern tile cells). It is level synchronous: all states at
+cost d are closed under free moves (blank swaps with a non pattern tile)
+before the moves of pattern tiles open level d + 1. Every frontier is
+split across threads and states are claimed with a CAS on a byte array.
+The table keeps the minimum over the blank cells.
+
+Indexing: the cells of the pattern tiles form a k-permutation of the
+board cells, ranked with a mixed radix (perfect hash, no empty slots).
+
+Storage: a pattern's value is never below the Manhattan distance of its
+tiles and has the same parity, so each entry is (pdb - manhattan) / 2,
+saturated at 15 and packed two to a byte. Saturation only lowers the
+estimate, so it stays admissible. save() writes a small header plus the
+packed table, load() maps the file with mmap instead of reading it.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "state_space.h"
+
+template <int Side>
+class PatternDatabase
+{
+public:
+    static const int CELLS = Side * Side;
+    typedef PackedState<4, CELLS> State;
+
+    PatternDatabase() = default;
+    PatternDatabase(const PatternDatabase &) = delete;
+    PatternDatabase &operator=(const PatternDatabase &) = delete;
+
+    PatternDatabase(PatternDatabase &&o) noexcept
+    {
+        *this = std::move(o);
+    }
+
+    PatternDatabase &operator=(PatternDatabase &&o) noexcept
+    {
+        if (this != &o)
+        {
+            unmap();
+            pattern = std::move(o.pattern);
+            owned = std::move(o.owned);
+            entries = o.entries;
+            mapped = o.mapped;
+            mappedBytes = o.mappedBytes;
+            data = mapped ? o.data : owned.data();
+            o.mapped = nullptr;
+            o.data = nullptr;
+            o.entries = 0;
+        }
+        return *this;
+    }
+
+    ~PatternDatabase()
+    {
+        unmap();
+    }
+
+    // tiles are the pattern (1 .. CELLS - 1, the blank is never part of it)
+    void build(const std::vector<int> &tiles, int numThreads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        unmap();
+        pattern = tiles;
+        int k = pattern.size();
+        numThreads = std::max(1, numThreads);
+
+        // abstract state: positions[0] is the blank, positions[1 + j] is pattern[j]
+        uint64_t numAbstract = permutations(k + 1);
+        std::vector<std::atomic<uint8_t>> dist(numAbstract);
+        for (uint64_t i = 0; i < numAbstract; ++i)
+            dist[i].store(UNSEEN, std::memory_order_relaxed);
+
+        int goal[CELLS + 1];
+        goal[0] = 0;
+        for (int j = 0; j < k; ++j)
+            goal[1 + j] = pattern[j];
+        uint32_t goalIdx = rank(goal, k + 1);
+        dist[goalIdx].store(0, std::memory_order_relaxed);
+
+        std::vector<uint32_t> frontier = {goalIdx};
+        for (int d = 0; !frontier.empty(); ++d)
+        {
+            // close level d under free moves
+            std::vector<uint32_t> level = frontier;
+            std::vector<uint32_t> current = std::move(frontier);
+            while (!current.empty())
+            {
+                std::vector<uint32_t> next;
+                expand(current, k, false, d, dist, next, numThreads);
+                level.insert(level.end(), next.begin(), next.end());
+                current = std::move(next);
+            }
+
+            // moves of pattern tiles open the next level
+            frontier.clear();
+            if (d + 1 < UNSEEN)
+                expand(level, k, true, d + 1, dist, frontier, numThreads);
+        }
+
+        // project out the blank and pack the deltas
+        entries = permutations(k);
+        owned.assign((entries + 1) / 2, 0);
+        data = owned.data();
+        parallelFor(entries, numThreads, [&](uint64_t begin, uint64_t end)
+                    {
+                        int positions[CELLS + 1];
+                        for (uint64_t idx = begin; idx < end; ++idx)
+                        {
+                            unrank(idx, k, positions + 1);
+                            uint32_t used = 0;
+                            for (int j = 0; j < k; ++j)
+                                used |= 1u << positions[1 + j];
+
+                            int best = UNSEEN;
+                            for (int blank = 0; blank < CELLS; ++blank)
+                            {
+                                if (used >> blank & 1)
+                                    continue;
+                                positions[0] = blank;
+                                best = std::min<int>(best, dist[rank(positions, k + 1)].load(std::memory_order_relaxed));
+                            }
+
+                            int delta = std::min(15, (best - manhattan(positions + 1)) / 2);
+                            // two entries share a byte, but idx and idx ^ 1 are
+                            // always in the same chunk (chunks are even sized)
+                            owned[idx / 2] |= delta << (4 * (idx & 1));
+                        } });
+    }
+
+    bool save(const std::string &filename) const
+    {
+        FILE *file = fopen(filename.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        Header header = makeHeader();
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(data, 1, (entries + 1) / 2, file) == (entries + 1) / 2;
+        return fclose(file) == 0 && ok;
+    }
+
+    // maps the table read-only, false if the file is missing, truncated or
+    // does not hold a valid PDB for this board size
+    bool load(const std::string &filename)
+    {
+        unmap();
+        owned.clear();
+        data = nullptr;
+
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header))
+        {
+            close(fd);
+            return false;
+        }
+
+        void *base = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // the mapping keeps the file alive
+        if (base == MAP_FAILED)
+            return false;
+
+        // everything lookup relies on is checked before the mapping is
+        // used: the tiles index cellOf and the entry count sizes the table
+        Header header;
+        memcpy(&header, base, sizeof(header));
+        bool valid = memcmp(header.magic, "PDB1", 4) == 0 && header.side == Side && header.count > 0 &&
+                     header.count < CELLS && header.entries == permutations(header.count);
+        uint32_t seen = 0;
+        for (int j = 0; valid && j < header.count; ++j)
+        {
+            int tile = header.tiles[j];
+            valid = tile >= 1 && tile < CELLS && !(seen >> tile & 1);
+            seen |= 1u << (tile & 31);
+        }
+        if (!valid || (size_t)info.st_size < sizeof(Header) + (header.entries + 1) / 2)
+        {
+            munmap(base, info.st_size);
+            return false;
+        }
+
+        pattern.assign(header.tiles, header.tiles + header.count);
+        entries = header.entries;
+        mapped = base;
+        mappedBytes = info.st_size;
+        data = (const uint8_t *)base + sizeof(Header);
+        return true;
+    }
+
+    // cellOf[tile] is the cell of each tile
+    int lookup(const int *cellOf) const
+    {
+        int positions[CELLS];
+        int k = pattern.size();
+        for (int j = 0; j < k; ++j)
+            positions[j] = cellOf[pattern[j]];
+
+        uint64_t idx = rank(positions, k);
+        int delta = (data[idx / 2] >> (4 * (idx & 1))) & 15;
+        return manhattan(positions) + 2 * delta;
+    }
+
+    int value(const State &s) const
+    {
+        int cellOf[CELLS];
+        for (int cell = 0; cell < CELLS; ++cell)
+            cellOf[s.get(cell)] = cell;
+        return lookup(cellOf);
+    }
+
+    const std::vector<int> &tiles() const
+    {
+        return pattern;
+    }
+
+    uint64_t size() const
+    {
+        return entries;
+    }
+
+    size_t memoryBytes() const
+    {
+        return (entries + 1) / 2;
+    }
+
+private:
+    static const uint8_t UNSEEN = 255;
+
+    struct Header
+    {
+        char magic[4];
+        int32_t side;
+        int32_t count;
+        int32_t tiles[CELLS];
+        uint64_t entries;
+    };
+
+    std::vector<int> pattern;
+    std::vector<uint8_t> owned;
+    const uint8_t *data = nullptr;
+    uint64_t entries = 0;
+    void *mapped = nullptr;
+    size_t mappedBytes = 0;
+
+    Header makeHeader() const
+    {
+        Header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "PDB1", 4);
+        header.side = Side;
+        header.count = pattern.size();
+        std::copy(pattern.begin(), pattern.end(), header.tiles);
+        header.entries = entries;
+        return header;
+    }
+
+    void unmap()
+    {
+        if (mapped != nullptr)
+            munmap(mapped, mappedBytes);
+        mapped = nullptr;
+        mappedBytes = 0;
+    }
+
+    static uint64_t permutations(int count)
+    {
+        uint64_t total = 1;
+        for (int i = 0; i < count; ++i)
+            total *= CELLS - i;
+        return total;
+    }
+
+    // mixed radix rank of distinct cells: digit i counts the free cells
+    // below positions[i], in base CELLS - i
+    static uint64_t rank(const int *positions, int count)
+    {
+        uint32_t used = 0;
+        uint64_t idx = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            int digit = positions[i] - __builtin_popcount(used & ((1u << positions[i]) - 1));
+            idx = idx * (CELLS - i) + digit;
+            used |= 1u << positions[i];
+        }
+        return idx;
+    }
+
+    static void unrank(uint64_t idx, int count, int *positions)
+    {
+        int digits[CELLS];
+        for (int i = count - 1; i >= 0; --i)
+        {
+            digits[i] = idx % (CELLS - i);
+            idx /= CELLS - i;
+        }
+
+        uint32_t used = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            int skip = digits[i];
+            int cell = 0;
+            while (true)
+            {
+                if (!(used >> cell & 1) && skip-- == 0)
+                    break;
+                cell++;
+            }
+            positions[i] = cell;
+            used |= 1u << cell;
+        }
+    }
+
+    // Manhattan distance of the pattern tiles, tile t belongs in cell t
+    int manhattan(const int *positions) const
+    {
+        int total = 0;
+        for (size_t j = 0; j < pattern.size(); ++j)
+        {
+            int cell = positions[j], home = pattern[j];
+            total += std::abs(cell / Side - home / Side) + std::abs(cell % Side - home % Side);
+        }
+        return total;
+    }
+
+    // runs body(begin, end) on even sized chunks of [0, n)
+    template <typename Body>
+    static void parallelFor(uint64_t n, int numThreads, Body body)
+    {
+        uint64_t chunk = (n + numThreads - 1) / numThreads;
+        chunk += chunk & 1;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            uint64_t begin = t * chunk;
+            uint64_t end = std::min(n, begin + chunk);
+            if (begin < end)
+                workers.emplace_back(body, begin, end);
+        }
+        for (std::thread &w : workers)
+            w.join();
+    }
+
+    // claims every unseen neighbour of states reached by a free move
+    // (patternMoves == false) or by moving a pattern tile
+    void expand(const std::vector<uint32_t> &states, int k, bool patternMoves, int newDist,
+                std::vector<std::atomic<uint8_t>> &dist, std::vector<uint32_t> &out, int numThreads) const
+    {
+        std::vector<std::vector<uint32_t>> found(numThreads);
+        uint64_t chunk = (states.size() + numThreads - 1) / numThreads;
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            uint64_t begin = t * chunk;
+            uint64_t end = std::min<uint64_t>(states.size(), begin + chunk);
+            if (begin >= end)
+                continue;
+
+            workers.emplace_back([&, t, begin, end]()
+                                 {
+                                     int positions[CELLS + 1];
+                                     static const int dr[] = {-1, 1, 0, 0}, dc[] = {0, 0, -1, 1};
+                                     for (uint64_t i = begin; i < end; ++i)
+                                     {
+                                         unrank(states[i], k + 1, positions);
+                                         int blank = positions[0];
+                                         for (int m = 0; m < 4; ++m)
+                                         {
+                                             int r = blank / Side + dr[m], c = blank % Side + dc[m];
+                                             if (r < 0 || c < 0 || r >= Side || c >= Side)
+                                                 continue;
+                                             int cell = r * Side + c;
+
+                                             int tile = 0; // index in positions of the tile in cell
+                                             for (int j = 1; j <= k; ++j)
+                                             {
+                                                 if (positions[j] == cell)
+                                                     tile = j;
+                                             }
+                                             if ((tile != 0) != patternMoves)
+                                                 continue;
+
+                                             positions[0] = cell;
+                                             if (tile != 0)
+                                                 positions[tile] = blank;
+                                             uint32_t idx = rank(positions, k + 1);
+                                             positions[0] = blank;
+                                             if (tile != 0)
+                                                 positions[tile] = cell;
+
+                                             uint8_t expected = UNSEEN;
+                                             if (dist[idx].load(std::memory_order_relaxed) == UNSEEN &&
+                                                 dist[idx].compare_exchange_strong(expected, newDist, std::memory_order_relaxed))
+                                                 found[t].push_back(idx);
+                                         }
+                                     } });
+        }
+        for (std::thread &w : workers)
+            w.join();
+
+        for (const std::vector<uint32_t> &part : found)
+            out.insert(out.end(), part.begin(), part.end());
+    }
+};
+
+// the sum of disjoint pattern databases, plugs into the implicit searches
+// of implicit_search.cpp as a SlidingTilePuzzle with a stronger heuristic
+template <int Side>
+class PDBSlidingTilePuzzle : public SlidingTilePuzzle<Side>
+{
+public:
+    typedef typename SlidingTilePuzzle<Side>::State State;
+    typedef typename SlidingTilePuzzle<Side>::Cost Cost;
+
+    PDBSlidingTilePuzzle(const std::vector<int> &tiles, const std::vector<PatternDatabase<Side>> &pdbs)
+        : SlidingTilePuzzle<Side>(tiles), pdbs(pdbs)
+    {
+    }
+
+    Cost heuristic(const State &s) const
+    {
+        int cellOf[Side * Side];
+        for (int cell = 0; cell < Side * Side; ++cell)
+            cellOf[s.get(cell)] = cell;
+
+        int total = 0;
+        for (const PatternDatabase<Side> &pdb : pdbs)
+            total += pdb.lookup(cellOf);
+        return total;
+    }
+
+private:
+    const std::vector<PatternDatabase<Side>> &pdbs;
+};
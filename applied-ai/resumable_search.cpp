@@ -0,0 +1,412 @@
+/*
+Resumable (time-sliced) UCS, A* and Greedy Best First Search
+
+findPath in ucs.cpp, astar.cpp and gbfs.cpp runs to completion in one
+call. ResumableSearch keeps the whole search state (open list, g values,
+parents) in the object instead, so a query advances in slices:
+
+  step(budget)   expands at most budget nodes and returns the status
+  cancel()       stops the query at its next step (safe from any thread)
+  deadline       a query past its deadline stops with TIMED_OUT
+
+The three algorithms only differ in the priority of a node:
+
+  UCS    g          A*    g + h          GBFS    h
+
+When a query stops early, progress() still reports the frontier: the
+lowest priority on the open list (for UCS and an admissible A* it is a
+lower bound on the optimal cost) and the reached node closest to the
+target by the heuristic, whose path partialPath() returns.
+
+Edges are (neigh_idx, cost) as in astar.cpp.
+*/
+
+#include <vector>
+#include <utility>
+#include <queue>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <iostream>
+
+#include "weights.h"
+
+using namespace std;
+
+template <typename W = int>
+struct Node
+{
+    int id;
+    Node *next;
+    W g;
+};
+
+enum class SearchStatus
+{
+    RUNNING,
+    FOUND,
+    NOT_FOUND,
+    TIMED_OUT,
+    CANCELLED
+};
+
+const char *statusName(SearchStatus status)
+{
+    switch (status)
+    {
+    case SearchStatus::RUNNING:
+        return "RUNNING";
+    case SearchStatus::FOUND:
+        return "FOUND";
+    case SearchStatus::NOT_FOUND:
+        return "NOT_FOUND";
+    case SearchStatus::TIMED_OUT:
+        return "TIMED_OUT";
+    default:
+        return "CANCELLED";
+    }
+}
+
+template <typename W = int, typename Graph = vector<vector<pair<int, W>>>>
+class ResumableSearch
+{
+public:
+    enum Mode
+    {
+        UCS,
+        ASTAR,
+        GBFS
+    };
+
+    typedef chrono::steady_clock Clock;
+
+    struct Progress
+    {
+        long long expanded = 0;
+        size_t frontier = 0;  // entries on the open list
+        W bound;              // lowest priority on the open list
+        int closest = -1;     // reached node with the lowest h
+        W closestG;
+        W closestH;
+    };
+
+    // h(node, T) orders ASTAR and GBFS, UCS only uses it to report the
+    // closest node
+    ResumableSearch(const Graph &adj, int S, int T, Mode mode, function<W(int, int)> h = nullptr)
+        : adj(adj), S(S), T(T), mode(mode), h(h), cancelled(false)
+    {
+        int n = adj.size();
+        visited.assign(n, 0);
+        parents.assign(n, -1);
+        g.assign(n, Traits::infinity());
+
+        g[S] = Traits::zero();
+        info.closest = S;
+        info.closestG = Traits::zero();
+        info.closestH = heuristic(S);
+        info.bound = Traits::infinity();
+        pq.push(make_pair(priority(S), S));
+    }
+
+    void setDeadline(Clock::time_point when)
+    {
+        deadline = when;
+        hasDeadline = true;
+    }
+
+    void setTimeout(chrono::microseconds timeout)
+    {
+        setDeadline(Clock::now() + timeout);
+    }
+
+    // may be called from another thread, takes effect at the next step
+    void cancel()
+    {
+        cancelled.store(true, memory_order_relaxed);
+    }
+
+    SearchStatus status() const
+    {
+        return state;
+    }
+
+    SearchStatus step(int budget)
+    {
+        if (state != SearchStatus::RUNNING)
+            return state;
+        if (cancelled.load(memory_order_relaxed))
+            return finish(SearchStatus::CANCELLED);
+
+        for (int i = 0; i < budget; ++i)
+        {
+            // the clock is not free, look at it every few expansions
+            if (hasDeadline && (i & 63) == 0 && Clock::now() >= deadline)
+                return finish(SearchStatus::TIMED_OUT);
+
+            if (pq.empty())
+                return finish(SearchStatus::NOT_FOUND);
+
+            Entry curr = pq.top();
+            pq.pop();
+            int U = curr.second;
+            if (visited[U])
+                continue; // we skip those rubbish nodes with higher costs
+
+            visited[U] = true;
+            info.expanded++;
+
+            if (U == T)
+                return finish(SearchStatus::FOUND);
+
+            for (pair<int, W> edge : adj[U])
+            {
+                int N = edge.first;
+                if (visited[N])
+                    continue;
+
+                W newG = Traits::add(g[U], edge.second);
+                // GBFS keeps the first parent, like gbfs.cpp
+                bool better = mode == GBFS ? g[N] == Traits::infinity() : newG < g[N];
+                if (!better)
+                    continue;
+
+                parents[N] = U;
+                g[N] = newG;
+                pq.push(make_pair(priority(N), N));
+
+                W hN = heuristic(N);
+                if (hN < info.closestH)
+                {
+                    info.closest = N;
+                    info.closestG = g[N];
+                    info.closestH = hN;
+                }
+            }
+        }
+
+        if (pq.empty())
+            return finish(SearchStatus::NOT_FOUND);
+        return state;
+    }
+
+    // runs to completion (or deadline / cancellation)
+    SearchStatus run()
+    {
+        while (step(1 << 16) == SearchStatus::RUNNING)
+            ;
+        return state;
+    }
+
+    Progress progress() const
+    {
+        Progress out = info;
+        out.frontier = pq.size();
+        out.bound = pq.empty() ? Traits::infinity() : pq.top().first;
+        return out;
+    }
+
+    // the path to T, only once the status is FOUND
+    Node<W> *path() const
+    {
+        if (state != SearchStatus::FOUND)
+            return nullptr;
+        return buildPath(T);
+    }
+
+    // path to the reached node closest to T, useful after a timeout
+    Node<W> *partialPath() const
+    {
+        return buildPath(info.closest);
+    }
+
+    void printPath(Node<W> *head)
+    {
+        if (head == nullptr)
+            return;
+
+        while (head->next != nullptr)
+        {
+            cout << head->id << ", " << head->g << "->";
+            head = head->next;
+        }
+        cout << head->id << ", " << head->g << endl;
+    }
+
+    void deletePath(Node<W> *head)
+    {
+        if (head == nullptr)
+            return;
+
+        Node<W> *curr = head;
+        while (curr->next != nullptr)
+        {
+            Node<W> *nextNode = curr->next;
+            delete curr;
+            curr = nextNode;
+        }
+        delete curr;
+    }
+
+private:
+    typedef WeightTraits<W> Traits;
+    typedef pair<W, int> Entry; // (priority, node_idx)
+
+    const Graph &adj;
+    int S, T;
+    Mode mode;
+    function<W(int, int)> h;
+
+    vector<bool> visited;
+    vector<int> parents;
+    vector<W> g;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> pq;
+
+    SearchStatus state = SearchStatus::RUNNING;
+    atomic<bool> cancelled;
+    bool hasDeadline = false;
+    Clock::time_point deadline;
+    Progress info;
+
+    W heuristic(int v) const
+    {
+        return h ? h(v, T) : Traits::zero();
+    }
+
+    W priority(int v) const
+    {
+        if (mode == UCS)
+            return g[v];
+        if (mode == ASTAR)
+            return Traits::add(g[v], heuristic(v));
+        return heuristic(v);
+    }
+
+    SearchStatus finish(SearchStatus result)
+    {
+        state = result;
+        if (result == SearchStatus::FOUND || result == SearchStatus::NOT_FOUND)
+        {
+            // the frontier is no use any more, give the memory back
+            pq = priority_queue<Entry, vector<Entry>, greater<Entry>>();
+        }
+        return state;
+    }
+
+    Node<W> *buildPath(int target) const
+    {
+        if (target < 0 || (target != S && parents[target] == -1))
+            return nullptr;
+
+        int curr = target;
+        Node<W> *head = new Node<W>{curr, nullptr, g[curr]};
+        while (curr != S)
+        {
+            curr = parents[curr];
+            head = new Node<W>{curr, head, g[curr]};
+        }
+        return head;
+    }
+};
+
+// interleaves many queries on one thread: each gets a slice of budget
+// expansions in turn until it leaves the RUNNING state
+template <typename Search>
+void runRoundRobin(vector<Search *> &queries, int budget)
+{
+    deque<Search *> ready(queries.begin(), queries.end());
+    while (!ready.empty())
+    {
+        Search *query = ready.front();
+        ready.pop_front();
+        if (query->step(budget) == SearchStatus::RUNNING)
+            ready.push_back(query);
+    }
+}
+
+struct Point
+{
+    double x;
+    double y;
+};
+
+int main()
+{
+    // random geometric graph, edges weighted by their length
+    int n = 200000;
+    mt19937 rng(7);
+    uniform_real_distribution<double> coord(0, 1000);
+    vector<Point> coords(n);
+    for (Point &p : coords)
+        p = {coord(rng), coord(rng)};
+
+    auto dist = [&coords](int i, int j)
+    {
+        double dx = coords[i].x - coords[j].x;
+        double dy = coords[i].y - coords[j].y;
+        return sqrt(dx * dx + dy * dy);
+    };
+
+    vector<vector<pair<int, double>>> adj(n);
+    for (int u = 0; u < n; ++u)
+    {
+        // a ring plus a few random chords keeps everything connected
+        int ring = (u + 1) % n;
+        adj[u].push_back({ring, dist(u, ring)});
+        adj[ring].push_back({u, dist(u, ring)});
+        for (int k = 0; k < 2; ++k)
+        {
+            int v = rng() % n;
+            adj[u].push_back({v, dist(u, v)});
+            adj[v].push_back({u, dist(u, v)});
+        }
+    }
+
+    typedef ResumableSearch<double> Search;
+    vector<Search *> queries = {
+        new Search(adj, 0, 123456, Search::UCS),
+        new Search(adj, 0, 123456, Search::ASTAR, dist),
+        new Search(adj, 0, 123456, Search::GBFS, dist),
+        new Search(adj, 42, 4242, Search::ASTAR, dist),
+        new Search(adj, 42, 4242, Search::UCS, dist), // will be cancelled
+        new Search(adj, 7, 77777, Search::UCS, dist), // tight deadline
+    };
+    queries[5]->setTimeout(chrono::milliseconds(5));
+
+    // cancel one query after a couple of slices
+    queries[4]->step(100);
+    queries[4]->cancel();
+
+    runRoundRobin(queries, 1000);
+
+    const char *modes[] = {"UCS", "A*", "GBFS", "A*", "UCS", "UCS"};
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        Search *q = queries[i];
+        Search::Progress p = q->progress();
+        cout << modes[i] << ": " << statusName(q->status()) << ", expanded " << p.expanded;
+
+        Node<double> *path = q->path();
+        if (path != nullptr)
+        {
+            Node<double> *last = path;
+            while (last->next != nullptr)
+                last = last->next;
+            cout << ", cost " << last->g;
+            q->deletePath(path);
+        }
+        else
+        {
+            cout << ", frontier " << p.frontier << ", lower bound " << p.bound << ", closest node "
+                 << p.closest << " (g " << p.closestG << ", h " << p.closestH << ")";
+        }
+        cout << endl;
+    }
+
+    for (Search *q : queries)
+        delete q;
+
+    return 0;
+}
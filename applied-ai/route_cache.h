@@ -0,0 +1,261 @@
+/*
+Result cache for repeated origins and destinations
+
+Sits in front of a point-to-point search such as UCS::findPath or
+AStar::findPath and keeps two kinds of entries in one LRU list:
+
+  - recent (S, T) answers: the path and its cost;
+  - full one-to-all shortest-path trees (parents + dist) for hot sources,
+    i.e. sources that were asked for at least hotThreshold times. Any
+    later target from a cached source is answered by walking parents,
+    without searching.
+
+The total size of the entries is capped at maxBytes (least recently used
+entries are evicted first) and everything is dropped when the graph
+version changes. All methods are thread-safe; the searches themselves
+run outside the lock. findPath wraps the whole protocol, callers that
+batch their own searches can use lookup / recordMiss / store* directly.
+*/
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+template <typename Cost>
+class RouteCache
+{
+public:
+    struct Route
+    {
+        bool found = false;
+        Cost cost = Cost();
+        std::vector<int> path; // S ... T
+    };
+
+    struct Stats
+    {
+        long long routeHits = 0;
+        long long treeHits = 0;
+        long long misses = 0;
+        long long treesBuilt = 0;
+        long long evictions = 0;
+    };
+
+    RouteCache(size_t maxBytes, int hotThreshold = 3)
+        : maxBytes(maxBytes), hotThreshold(hotThreshold)
+    {
+    }
+
+    // drops every entry if the graph changed since the last call
+    void setGraphVersion(uint64_t version)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (version != graphVersion)
+        {
+            clearLocked();
+            graphVersion = version;
+        }
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        clearLocked();
+    }
+
+    // search(S, T) answers one query and returns a Route, buildTree(S,
+    // parents, dist) fills a one-to-all tree (parents[S] == -1 and
+    // parents[v] == -1 for unreachable v)
+    template <typename Search, typename BuildTree>
+    Route findPath(int S, int T, Search search, BuildTree buildTree)
+    {
+        Route route;
+        if (lookup(S, T, route))
+            return route;
+
+        if (recordMiss(S))
+        {
+            std::vector<int> parents;
+            std::vector<Cost> dist;
+            buildTree(S, parents, dist);
+            route = fromTree(S, T, parents, dist);
+            storeTree(S, std::move(parents), std::move(dist));
+            return route;
+        }
+
+        route = search(S, T);
+        storeRoute(S, T, route);
+        return route;
+    }
+
+    // counts a miss for S, true once S is hot enough to deserve a tree
+    bool recordMiss(int S)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stats.misses++;
+        bool hot = ++sourceCount[S] >= hotThreshold;
+        if (sourceCount.size() > MAX_COUNTED_SOURCES)
+            decayCounts();
+        return hot;
+    }
+
+    void storeRoute(int S, int T, const Route &route)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t bytes = sizeof(Entry) + sizeof(Route) + route.path.size() * sizeof(int) + 64;
+        if (bytes > maxBytes || routes.count(key(S, T)) || trees.count(S))
+            return;
+
+        lru.push_front({S, T, bytes});
+        routes.emplace(key(S, T), std::make_pair(route, lru.begin()));
+        usedBytes += bytes;
+        evictLocked();
+    }
+
+    void storeTree(int S, std::vector<int> parents, std::vector<Cost> dist)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        sourceCount.erase(S);
+        size_t bytes = sizeof(Entry) + sizeof(Tree) + parents.size() * sizeof(int) + dist.size() * sizeof(Cost) + 64;
+        if (bytes > maxBytes || trees.count(S))
+            return;
+
+        lru.push_front({S, -1, bytes});
+        trees.emplace(S, std::make_pair(Tree{std::move(parents), std::move(dist)}, lru.begin()));
+        usedBytes += bytes;
+        stats.treesBuilt++;
+        evictLocked();
+    }
+
+    static Route fromTree(int S, int T, const std::vector<int> &parents, const std::vector<Cost> &dist)
+    {
+        Route route;
+        if (T != S && parents[T] == -1)
+            return route;
+
+        for (int curr = T; curr != -1; curr = parents[curr])
+            route.path.push_back(curr);
+        std::reverse(route.path.begin(), route.path.end());
+        route.found = true;
+        route.cost = dist[T];
+        return route;
+    }
+
+    bool lookup(int S, int T, Route &out)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return lookupLocked(S, T, out);
+    }
+
+    Stats lastStats()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+    size_t bytesUsed()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return usedBytes;
+    }
+
+private:
+    static const size_t MAX_COUNTED_SOURCES = 1 << 16;
+
+    struct Tree
+    {
+        std::vector<int> parents;
+        std::vector<Cost> dist;
+    };
+
+    // one LRU list for both kinds of entry, T == -1 marks a tree
+    struct Entry
+    {
+        int S;
+        int T;
+        size_t bytes;
+    };
+
+    static uint64_t key(int S, int T)
+    {
+        return ((uint64_t)(uint32_t)S << 32) | (uint32_t)T;
+    }
+
+    std::mutex lock;
+    size_t maxBytes;
+    int hotThreshold;
+    uint64_t graphVersion = 0;
+    size_t usedBytes = 0;
+    Stats stats;
+
+    std::list<Entry> lru; // most recent first
+    std::unordered_map<uint64_t, std::pair<Route, typename std::list<Entry>::iterator>> routes;
+    std::unordered_map<int, std::pair<Tree, typename std::list<Entry>::iterator>> trees;
+    std::unordered_map<int, int> sourceCount;
+
+    bool lookupLocked(int S, int T, Route &out)
+    {
+        auto tree = trees.find(S);
+        if (tree != trees.end())
+        {
+            lru.splice(lru.begin(), lru, tree->second.second);
+            out = fromTree(S, T, tree->second.first.parents, tree->second.first.dist);
+            stats.treeHits++;
+            return true;
+        }
+
+        auto route = routes.find(key(S, T));
+        if (route != routes.end())
+        {
+            lru.splice(lru.begin(), lru, route->second.second);
+            out = route->second.first;
+            stats.routeHits++;
+            return true;
+        }
+        return false;
+    }
+
+    void evictLocked()
+    {
+        while (usedBytes > maxBytes && !lru.empty())
+        {
+            const Entry &last = lru.back();
+            if (last.T == -1)
+                trees.erase(last.S);
+            else
+                routes.erase(key(last.S, last.T));
+            usedBytes -= last.bytes;
+            lru.pop_back();
+            stats.evictions++;
+        }
+    }
+
+    // halve the counters so sources that stopped being hot age out
+    void decayCounts()
+    {
+        for (auto it = sourceCount.begin(); it != sourceCount.end();)
+        {
+            it->second /= 2;
+            if (it->second == 0)
+                it = sourceCount.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void clearLocked()
+    {
+        lru.clear();
+        routes.clear();
+        trees.clear();
+        sourceCount.clear();
+        usedBytes = 0;
+    }
+};
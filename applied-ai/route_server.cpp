@@ -0,0 +1,874 @@
+/*
+Simple long-running route server
+
+The graph (route_finding.csv format: "CityA,CityB,Distance(miles)") is
+loaded once at start-up, and the landmark tables used by the ALT
+heuristic are computed once and kept warm for every query.
+
+Queries are line-delimited JSON objects, read from stdin or from a Unix
+socket (--socket PATH):
+
+  {"id": 1, "from": "York", "to": "Portsmouth", "avoid": "London"}
+
+and every query gets one JSON line back (in completion order, so use id
+to match them):
+
+  {"id": 1, "found": true, "cost": 262, "path": ["York", ..., "Portsmouth"]}
+
+Worker threads take the queries from a shared queue in micro-batches.
+Queries in a batch with the same origin (and city to avoid) are answered
+by a single one-to-many Dijkstra; a lone query runs A* with the landmark
+heuristic.
+
+Answers without a city to avoid go through a RouteCache: repeated (S, T)
+pairs are served from memory, and hot origins get a full shortest-path
+tree. Two commands manage it:
+
+  {"cmd": "reload"}  re-reads the graph file and invalidates the cache
+  {"cmd": "stats"}   reports the cache hit counters
+
+Build and try it locally:
+  g++ -std=c++17 -O2 -pthread route_server.cpp -o route_server
+  echo '{"id":1,"from":"York","to":"Portsmouth"}' | ./route_server formative_assessment/data/route_finding.csv
+*/
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <queue>
+#include <deque>
+#include <unordered_map>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <shared_mutex>
+#include <cerrno>
+#include <csignal>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "route_cache.h"
+#include "csv_loader.h"
+
+using namespace std;
+
+const double INF = numeric_limits<double>::infinity();
+
+// minimal JSON support for flat objects with string/number/bool/null values
+namespace json
+{
+    struct Value
+    {
+        string text;           // unescaped for strings, verbatim otherwise
+        bool isString = false; // false: a number, true, false or null
+    };
+
+    // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool isNumber(const string &s)
+    {
+        size_t i = 0;
+        auto digits = [&]()
+        {
+            size_t start = i;
+            while (i < s.size() && isdigit((unsigned char)s[i]))
+                i++;
+            return i > start;
+        };
+        if (i < s.size() && s[i] == '-')
+            i++;
+        if (i < s.size() && s[i] == '0')
+            i++;
+        else if (!digits())
+            return false;
+        if (i < s.size() && s[i] == '.')
+        {
+            i++;
+            if (!digits())
+                return false;
+        }
+        if (i < s.size() && (s[i] == 'e' || s[i] == 'E'))
+        {
+            i++;
+            if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+                i++;
+            if (!digits())
+                return false;
+        }
+        return i == s.size();
+    }
+
+    bool parseObject(const string &line, map<string, Value> &out)
+    {
+        size_t i = 0;
+        auto skipSpaces = [&]()
+        {
+            while (i < line.size() && isspace((unsigned char)line[i]))
+                i++;
+        };
+        auto parseString = [&](string &s) -> bool
+        {
+            if (i >= line.size() || line[i] != '"')
+                return false;
+            i++;
+            s.clear();
+            while (i < line.size() && line[i] != '"')
+            {
+                char c = line[i++];
+                if ((unsigned char)c < 0x20)
+                    return false; // control characters must be escaped
+                if (c != '\\')
+                {
+                    s += c;
+                    continue;
+                }
+                if (i >= line.size())
+                    return false;
+                char e = line[i++];
+                switch (e)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    s += e;
+                    break;
+                case 'b':
+                    s += '\b';
+                    break;
+                case 'f':
+                    s += '\f';
+                    break;
+                case 'n':
+                    s += '\n';
+                    break;
+                case 'r':
+                    s += '\r';
+                    break;
+                case 't':
+                    s += '\t';
+                    break;
+                case 'u':
+                {
+                    // \uXXXX as UTF-8; surrogate pairs are not combined
+                    if (i + 4 > line.size())
+                        return false;
+                    unsigned code = 0;
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        char h = line[i++];
+                        if (!isxdigit((unsigned char)h))
+                            return false;
+                        code = code * 16 + (isdigit((unsigned char)h) ? h - '0' : tolower(h) - 'a' + 10);
+                    }
+                    if (code < 0x80)
+                        s += (char)code;
+                    else if (code < 0x800)
+                    {
+                        s += (char)(0xC0 | (code >> 6));
+                        s += (char)(0x80 | (code & 0x3F));
+                    }
+                    else
+                    {
+                        s += (char)(0xE0 | (code >> 12));
+                        s += (char)(0x80 | ((code >> 6) & 0x3F));
+                        s += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            if (i >= line.size())
+                return false;
+            i++;
+            return true;
+        };
+
+        out.clear();
+        skipSpaces();
+        if (i >= line.size() || line[i++] != '{')
+            return false;
+        skipSpaces();
+        if (i < line.size() && line[i] == '}')
+            return true;
+
+        while (i < line.size())
+        {
+            string key;
+            Value value;
+            skipSpaces();
+            if (!parseString(key))
+                return false;
+            skipSpaces();
+            if (i >= line.size() || line[i++] != ':')
+                return false;
+            skipSpaces();
+            if (i < line.size() && line[i] == '"')
+            {
+                if (!parseString(value.text))
+                    return false;
+                value.isString = true;
+            }
+            else
+            {
+                size_t start = i;
+                while (i < line.size() && line[i] != ',' && line[i] != '}' && !isspace((unsigned char)line[i]))
+                    i++;
+                value.text = line.substr(start, i - start);
+                if (value.text != "true" && value.text != "false" && value.text != "null" && !isNumber(value.text))
+                    return false;
+            }
+            out[key] = value;
+
+            skipSpaces();
+            if (i < line.size() && line[i] == ',')
+            {
+                i++;
+                continue;
+            }
+            return i < line.size() && line[i] == '}';
+        }
+        return false;
+    }
+
+    string quote(const string &s)
+    {
+        string out = "\"";
+        for (char c : s)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\b':
+                out += "\\b";
+                break;
+            case '\f':
+                out += "\\f";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if ((unsigned char)c < 0x20)
+                {
+                    char code[8];
+                    snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+                    out += code;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        return out + "\"";
+    }
+
+    // a parsed value written back with the same type
+    string write(const Value &value)
+    {
+        return value.isString ? quote(value.text) : value.text;
+    }
+}
+
+class RoadGraph
+{
+public:
+    vector<string> names;
+    unordered_map<string, int> ids;
+    vector<vector<pair<int, double>>> adj; // (neighbour, miles)
+
+    int idOf(const string &name)
+    {
+        auto it = ids.find(name);
+        if (it != ids.end())
+            return it->second;
+        ids[name] = names.size();
+        names.push_back(name);
+        adj.emplace_back();
+        return names.size() - 1;
+    }
+
+    int find(const string &name) const
+    {
+        auto it = ids.find(name);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    bool load(const string &filename)
+    {
+        // the header's distance is not a number, so it is skipped
+        return csv::forEachRow(filename, [&](const string_view *fields, size_t count)
+                               {
+                                   double miles;
+                                   if (count < 3 || !csv::parseNumber(fields[2], miles))
+                                       return;
+
+                                   int u = idOf(string(fields[0]));
+                                   int v = idOf(string(fields[1]));
+                                   adj[u].push_back({v, miles}); // undirected graph
+                                   adj[v].push_back({u, miles}); });
+    }
+};
+
+// ALT heuristic: distances from a few far-apart landmarks, computed once
+class Landmarks
+{
+private:
+    vector<vector<double>> dist; // dist[l][v]
+
+public:
+    static vector<double> dijkstra(const RoadGraph &g, int S)
+    {
+        vector<double> d(g.adj.size(), INF);
+        priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+        d[S] = 0.0;
+        pq.push({0.0, S});
+        while (!pq.empty())
+        {
+            auto [cost, u] = pq.top();
+            pq.pop();
+            if (cost > d[u])
+                continue;
+            for (auto [v, w] : g.adj[u])
+            {
+                if (d[u] + w < d[v])
+                {
+                    d[v] = d[u] + w;
+                    pq.push({d[v], v});
+                }
+            }
+        }
+        return d;
+    }
+
+    void build(const RoadGraph &g, int count)
+    {
+        dist.clear();
+        int n = g.adj.size();
+        if (n == 0)
+            return;
+
+        // farthest-point selection: each landmark is the node farthest
+        // from the ones already chosen
+        vector<double> closest(n, INF);
+        int next = 0;
+        for (int l = 0; l < count && l < n; ++l)
+        {
+            dist.push_back(dijkstra(g, next));
+            for (int v = 0; v < n; ++v)
+            {
+                if (dist.back()[v] < INF)
+                    closest[v] = min(closest[v], dist.back()[v]);
+            }
+            next = max_element(closest.begin(), closest.end()) - closest.begin();
+        }
+    }
+
+    double h(int v, int T) const
+    {
+        double best = 0.0;
+        for (const vector<double> &d : dist)
+        {
+            if (d[v] < INF && d[T] < INF)
+                best = max(best, fabs(d[T] - d[v]));
+        }
+        return best;
+    }
+
+    size_t size() const
+    {
+        return dist.size();
+    }
+};
+
+// where the answer of a query has to be written; once the peer has gone
+// (EPIPE or any other write error) later answers are dropped
+class Responder
+{
+private:
+    int fd;
+    bool broken = false;
+    mutex lock;
+
+public:
+    explicit Responder(int fd) : fd(fd) {}
+
+    ~Responder()
+    {
+        if (fd != STDOUT_FILENO)
+            close(fd);
+    }
+
+    void send(const string &line)
+    {
+        lock_guard<mutex> guard(lock);
+        if (broken)
+            return;
+        string out = line + "\n";
+        size_t done = 0;
+        while (done < out.size())
+        {
+            ssize_t written = write(fd, out.data() + done, out.size() - done);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+            {
+                broken = true;
+                return;
+            }
+            done += written;
+        }
+    }
+};
+
+// the city names are resolved to ids only when the query is processed,
+// under the same graph lock as the search, so a reload in between cannot
+// leave it with ids of the old graph
+struct Query
+{
+    string id; // as JSON text, with the type it was sent with
+    string fromName, toName, avoidName;
+    int from = -1;
+    int to = -1;
+    int avoid = -1;
+    string error;
+    shared_ptr<Responder> reply;
+};
+
+class RouteServer
+{
+private:
+    typedef RouteCache<double>::Route Route;
+
+    RoadGraph graph;
+    Landmarks landmarks;
+    string graphFile;
+    int numLandmarks = 0;
+    uint64_t graphVersion = 0;
+    shared_mutex graphLock; // reload is exclusive, queries are shared
+    RouteCache<double> cache;
+
+    deque<Query> pending;
+    mutex queueLock;
+    condition_variable queueReady;
+    bool closing = false;
+
+    size_t batchSize;
+    chrono::microseconds batchWindow;
+
+    string answer(const Query &q, const Route &route)
+    {
+        ostringstream out;
+        out.precision(10);
+        out << "{\"id\": " << (q.id.empty() ? "null" : q.id);
+        if (!q.error.empty())
+        {
+            out << ", \"error\": " << json::quote(q.error) << "}";
+            return out.str();
+        }
+
+        if (!route.found)
+        {
+            out << ", \"found\": false, \"cost\": null, \"path\": []}";
+            return out.str();
+        }
+
+        out << ", \"found\": true, \"cost\": " << route.cost << ", \"path\": [";
+        for (size_t i = 0; i < route.path.size(); ++i)
+            out << (i ? ", " : "") << json::quote(graph.names[route.path[i]]);
+        out << "]}";
+        return out.str();
+    }
+
+    // one-to-many Dijkstra that stops once every target is settled (no
+    // targets means one-to-all); with a single target it is A* with the
+    // landmark heuristic
+    void search(int S, int avoid, const vector<int> &targets, vector<int> &parents, vector<double> &dist)
+    {
+        int n = graph.adj.size();
+        parents.assign(n, -1);
+        dist.assign(n, INF);
+        vector<char> settled(n, 0);
+
+        int T = targets.size() == 1 ? targets[0] : -1;
+        auto h = [&](int v)
+        { return T == -1 ? 0.0 : landmarks.h(v, T); };
+
+        vector<char> isTarget(n, 0);
+        bool all = targets.empty();
+        size_t left = 0;
+        for (int t : targets)
+        {
+            if (!isTarget[t])
+                left++;
+            isTarget[t] = 1;
+        }
+
+        priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> pq;
+        dist[S] = 0.0;
+        pq.push({h(S), S});
+
+        while (!pq.empty() && (all || left > 0))
+        {
+            int u = pq.top().second;
+            pq.pop();
+            if (settled[u])
+                continue;
+            settled[u] = 1;
+            if (isTarget[u])
+                left--;
+
+            for (auto [v, w] : graph.adj[u])
+            {
+                if (v == avoid || settled[v])
+                    continue;
+                if (dist[u] + w < dist[v])
+                {
+                    dist[v] = dist[u] + w;
+                    parents[v] = u;
+                    pq.push({dist[v] + h(v), v});
+                }
+            }
+        }
+
+        // nodes that were never settled are unreachable (or not needed)
+        for (int v = 0; v < n; ++v)
+        {
+            if (!settled[v])
+            {
+                dist[v] = INF;
+                parents[v] = -1;
+            }
+        }
+    }
+
+    // city names to ids in the current graph; needs graphLock
+    void resolve(Query &q) const
+    {
+        q.from = graph.find(q.fromName);
+        q.to = graph.find(q.toName);
+        q.avoid = q.avoidName.empty() ? -1 : graph.find(q.avoidName);
+
+        if (q.from == -1 || q.to == -1)
+            q.error = "unknown city";
+        else if (!q.avoidName.empty() && q.avoid == -1)
+            q.error = "unknown city to avoid";
+        else if (q.from == q.avoid || q.to == q.avoid)
+            q.error = "origin or destination is the avoided city";
+    }
+
+    void process(vector<Query> &batch)
+    {
+        shared_lock<shared_mutex> guard(graphLock);
+
+        // group by (origin, avoided city) so each group costs one search
+        map<pair<int, int>, vector<Query *>> groups;
+        for (Query &q : batch)
+        {
+            if (q.error.empty())
+                resolve(q);
+
+            Route cached;
+            if (!q.error.empty())
+                q.reply->send(answer(q, Route{}));
+            else if (q.avoid == -1 && cache.lookup(q.from, q.to, cached))
+                q.reply->send(answer(q, cached));
+            else
+                groups[{q.from, q.avoid}].push_back(&q);
+        }
+
+        vector<int> parents;
+        vector<double> dist;
+        for (auto &[key, queries] : groups)
+        {
+            int S = key.first;
+            bool cacheable = key.second == -1;
+
+            bool hot = false;
+            for (size_t i = 0; cacheable && i < queries.size(); ++i)
+                hot = cache.recordMiss(S) || hot;
+
+            vector<int> targets;
+            if (!hot)
+            {
+                for (Query *q : queries)
+                    targets.push_back(q->to);
+            }
+
+            search(S, key.second, targets, parents, dist);
+            for (Query *q : queries)
+            {
+                Route route = RouteCache<double>::fromTree(S, q->to, parents, dist);
+                if (cacheable && !hot)
+                    cache.storeRoute(S, q->to, route);
+                q->reply->send(answer(*q, route));
+            }
+
+            if (hot)
+                cache.storeTree(S, parents, dist);
+        }
+    }
+
+    // commands are answered directly by the reader thread
+    string command(const string &cmd)
+    {
+        if (cmd == "reload")
+        {
+            unique_lock<shared_mutex> guard(graphLock);
+            if (!loadLocked())
+                return "{\"error\": \"cannot reload graph\"}";
+            return "{\"reloaded\": true, \"version\": " + to_string(graphVersion) + "}";
+        }
+        if (cmd == "stats")
+        {
+            auto stats = cache.lastStats();
+            ostringstream out;
+            out << "{\"routeHits\": " << stats.routeHits << ", \"treeHits\": " << stats.treeHits
+                << ", \"misses\": " << stats.misses << ", \"treesBuilt\": " << stats.treesBuilt
+                << ", \"evictions\": " << stats.evictions << ", \"bytes\": " << cache.bytesUsed() << "}";
+            return out.str();
+        }
+        return "{\"error\": \"unknown command\"}";
+    }
+
+    bool loadLocked()
+    {
+        RoadGraph fresh;
+        if (!fresh.load(graphFile))
+            return false;
+        graph = move(fresh);
+        landmarks.build(graph, numLandmarks);
+        cache.setGraphVersion(++graphVersion);
+        cerr << "Loaded " << graph.names.size() << " cities, " << landmarks.size()
+             << " landmarks (graph version " << graphVersion << ")" << endl;
+        return true;
+    }
+
+    void worker()
+    {
+        vector<Query> batch;
+        while (true)
+        {
+            batch.clear();
+            {
+                unique_lock<mutex> guard(queueLock);
+                queueReady.wait(guard, [&]
+                                { return closing || !pending.empty(); });
+                if (pending.empty())
+                    return; // closing and nothing left
+
+                // wait a little to let a batch build up under load
+                if (pending.size() < batchSize && !closing)
+                    queueReady.wait_for(guard, batchWindow, [&]
+                                        { return closing || pending.size() >= batchSize; });
+
+                while (!pending.empty() && batch.size() < batchSize)
+                {
+                    batch.push_back(move(pending.front()));
+                    pending.pop_front();
+                }
+            }
+            process(batch);
+        }
+    }
+
+    void submit(const string &line, const shared_ptr<Responder> &reply)
+    {
+        Query q;
+        q.reply = reply;
+        map<string, json::Value> fields;
+        if (!json::parseObject(line, fields))
+        {
+            q.error = "malformed JSON";
+        }
+        else if (fields.count("cmd"))
+        {
+            reply->send(command(fields["cmd"].text));
+            return;
+        }
+        else
+        {
+            if (fields.count("id"))
+                q.id = json::write(fields["id"]);
+            q.fromName = fields["from"].text;
+            q.toName = fields["to"].text;
+            q.avoidName = fields.count("avoid") ? fields["avoid"].text : "";
+        }
+
+        {
+            lock_guard<mutex> guard(queueLock);
+            pending.push_back(move(q));
+        }
+        queueReady.notify_one();
+    }
+
+    void readLines(int fd, const shared_ptr<Responder> &reply)
+    {
+        string buffer;
+        char chunk[4096];
+        ssize_t got;
+        while ((got = read(fd, chunk, sizeof(chunk))) > 0)
+        {
+            buffer.append(chunk, got);
+            size_t start = 0, end;
+            while ((end = buffer.find('\n', start)) != string::npos)
+            {
+                string line = buffer.substr(start, end - start);
+                if (line.find_first_not_of(" \t\r") != string::npos)
+                    submit(line, reply);
+                start = end + 1;
+            }
+            buffer.erase(0, start);
+        }
+        if (buffer.find_first_not_of(" \t\r") != string::npos)
+            submit(buffer, reply);
+    }
+
+public:
+    RouteServer(size_t batchSize, chrono::microseconds batchWindow, size_t cacheBytes)
+        : cache(cacheBytes), batchSize(max<size_t>(batchSize, 1)), batchWindow(batchWindow)
+    {
+    }
+
+    bool load(const string &filename, int landmarkCount)
+    {
+        unique_lock<shared_mutex> guard(graphLock);
+        graphFile = filename;
+        numLandmarks = landmarkCount;
+        return loadLocked();
+    }
+
+    // answers stdin line by line until EOF
+    void serveStdin(int numThreads)
+    {
+        vector<thread> workers;
+        for (int t = 0; t < numThreads; ++t)
+            workers.emplace_back(&RouteServer::worker, this);
+
+        readLines(STDIN_FILENO, make_shared<Responder>(STDOUT_FILENO));
+
+        {
+            lock_guard<mutex> guard(queueLock);
+            closing = true;
+        }
+        queueReady.notify_all();
+        for (thread &w : workers)
+            w.join();
+    }
+
+    // answers every connection on a Unix socket, runs until killed
+    bool serveSocket(const string &path, int numThreads)
+    {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path))
+        {
+            cerr << "Socket path longer than " << sizeof(addr.sun_path) - 1 << " bytes: " << path << endl;
+            return false;
+        }
+        int server = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server < 0)
+            return false;
+
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        unlink(path.c_str());
+        if (bind(server, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(server, 64) < 0)
+        {
+            close(server);
+            return false;
+        }
+
+        for (int t = 0; t < numThreads; ++t)
+            thread(&RouteServer::worker, this).detach();
+
+        cerr << "Listening on " << path << endl;
+        while (true)
+        {
+            int client = accept(server, nullptr, nullptr);
+            if (client < 0)
+                continue;
+            // the responder closes the socket once the last answer is sent
+            thread([this, client]()
+                   {
+                       auto reply = make_shared<Responder>(dup(client));
+                       readLines(client, reply);
+                       close(client); })
+                .detach();
+        }
+    }
+};
+
+int main(int argc, char **argv)
+{
+    string filename = "formative_assessment/data/route_finding.csv";
+    string socketPath;
+    int numThreads = max(1u, thread::hardware_concurrency());
+    size_t batchSize = 32;
+    int numLandmarks = 4;
+    size_t cacheMB = 64;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc)
+            socketPath = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            numThreads = max(1, atoi(argv[++i]));
+        else if (arg == "--batch" && i + 1 < argc)
+            batchSize = max(1, atoi(argv[++i]));
+        else if (arg == "--landmarks" && i + 1 < argc)
+            numLandmarks = max(0, atoi(argv[++i]));
+        else if (arg == "--cache-mb" && i + 1 < argc)
+            cacheMB = max(0, atoi(argv[++i]));
+        else
+            filename = arg;
+    }
+
+    // a client that hangs up must not take the server down: writes to it
+    // fail with EPIPE instead
+    signal(SIGPIPE, SIG_IGN);
+
+    RouteServer server(batchSize, chrono::microseconds(500), cacheMB * 1024 * 1024);
+    if (!server.load(filename, numLandmarks))
+    {
+        cerr << "Cannot read " << filename << endl;
+        return 1;
+    }
+
+    if (socketPath.empty())
+    {
+        server.serveStdin(numThreads);
+        return 0;
+    }
+
+    if (!server.serveSocket(socketPath, numThreads))
+    {
+        cerr << "Cannot listen on " << socketPath << endl;
+        return 1;
+    }
+    return 0;
+}
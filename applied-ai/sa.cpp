@@ -7,9 +7,20 @@ Simple implementation of Simulated Annealing
 #include <random>
 #include <algorithm>
 #include <iostream>
-#include <sstream>
+#include <thread>
 #include <fstream>
 #include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <numeric>
+#include <cstdlib>
+
+#include "csv_loader.h"
+#include "dist_matrix.h"
+#include "dist_oracle.h"
+#include "tsp_moves.h"
+#include "tsp_construct.h"
+#include "multi_start.h"
 
 using namespace std;
 
@@ -33,7 +44,7 @@ void saveHistory(const string &filename, const vector<pair<double, double>> &his
     outFile.close();
 }
 
-void savePath(const string &filename, vector<int> &path, vector<Point> &coords)
+void savePath(const string &filename, const vector<int> &path, const vector<Point> &coords)
 {
     ofstream outFile(filename);
     if (!outFile.is_open())
@@ -54,55 +65,65 @@ void savePath(const string &filename, vector<int> &path, vector<Point> &coords)
 
 vector<Point> loadCoords(string filename)
 {
-    vector<Point> matrix;
-    ifstream file(filename);
-    string line;
     vector<double> coords;
+    csv::loadRows(filename, 2, coords, thread::hardware_concurrency());
 
-    while (getline(file, line))
+    vector<Point> matrix(coords.size() / 2);
+    for (size_t i = 0; i < matrix.size(); ++i)
     {
-        coords.clear();
-        string word;
-        istringstream iss(line);
-        int col = 0;
-        while (col < 2)
-        {
-            getline(iss, word, ',');
-            coords.push_back(stod(word));
-            col++;
-        }
-        if (coords.size() == 2)
-        {
-            matrix.push_back({coords[0], coords[1]});
-        }
+        matrix[i] = {coords[2 * i], coords[2 * i + 1]};
     }
 
     return matrix;
 }
 
-template <typename Distance>
-vector<vector<double>> calcDist(const vector<Point> &coords, Distance d)
+// acceptance counters of one rung of the parallel tempering ladder
+struct ReplicaStats
 {
-    int n = coords.size();
-    vector<vector<double>> distMat;
-    for (size_t i = 0; i < n; ++i)
-    {
-        vector<double> citydist;
-        for (size_t j = i + 1; j < n; ++j)
-        {
-            citydist.push_back(d(coords[i], coords[j]));
-        }
-        distMat.push_back(citydist);
-    }
-
-    return distMat;
-}
+    double temperature = 0.0;
+    long long proposed = 0;
+    long long accepted = 0;
+    long long swapsTried = 0; // exchanges with the next hotter rung
+    long long swapsAccepted = 0;
+};
 
 struct Solution
 {
     vector<int> path;
     vector<pair<double, double>> history;
     double distance = 0.0;
+    vector<ReplicaStats> replicas; // parallel tempering only, coldest first
+};
+
+// reusable: every wait() returns once count threads have called it
+class Barrier
+{
+public:
+    explicit Barrier(int count) : count(count) {}
+
+    void wait()
+    {
+        unique_lock<mutex> lock(m);
+        int gen = generation;
+        if (++arrived == count)
+        {
+            arrived = 0;
+            generation++;
+            released.notify_all();
+        }
+        else
+        {
+            released.wait(lock, [&]()
+                          { return gen != generation; });
+        }
+    }
+
+private:
+    mutex m;
+    condition_variable released;
+    int count;
+    int arrived = 0;
+    int generation = 0;
 };
 
 class SA
@@ -113,71 +134,166 @@ private:
         return deltaE < 0 ? 1.0 : exp(-deltaE) / temp;
     }
 
-public:
-    template <typename F>
-    Solution solve(vector<int> start, F f, double startT, double endT, double coolFactor)
+    // one Metropolis move at temp; true if it was accepted, with energy
+    // updated by its delta
+    template <typename Tour, typename D, typename Rng>
+    bool step(Tour &tour, double &energy, double temp, D d, tsp::Neighbourhood moves, Rng &gen)
     {
-        int numCities = start.size();
+        uniform_real_distribution<double> distProb(0.0, 1.0);
+        tsp::Move move = tsp::randomMove(tour, moves, gen);
+        double deltaE = tsp::moveDelta(tour, move, d);
+        if (deltaE < 0 || distProb(gen) < exp(-deltaE / temp))
+        {
+            tsp::applyMove(tour, move);
+            energy += deltaE;
+            return true;
+        }
+        return false;
+    }
 
+public:
+    // f is the tour length, d(u, v) the distance between two cities: each
+    // move is priced from its endpoint distances (tsp_moves.h) and the
+    // tour is only changed when the move is accepted. moves picks the
+    // random neighbourhood: 2-opt, Or-opt or both. Tour is the
+    // representation from tour.h; TwoLevelTour makes the flips O(sqrt(n)).
+    // The same seed gives the same run
+    template <typename Tour = tsp::ArrayTour, typename F, typename D>
+    Solution solve(vector<int> start, F f, D d, double startT, double endT, double coolFactor,
+                   tsp::Neighbourhood moves = tsp::TWO_OPT, uint64_t seed = random_device{}())
+    {
         vector<pair<double, double>> history;
-        vector<int> sol = start;
-        double bestDist = f(sol);
-        vector<int> bestPath = sol;
+        Tour sol(start);
+        double currE = f(start);
+        double bestDist = currE;
+        vector<int> bestPath = start;
         double temp = startT;
 
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_int_distribution<> dist(0, numCities - 1);
-        uniform_real_distribution<double> distProb(0.0, 1.0);
+        mt19937_64 gen(seed);
 
         while (temp > endT)
         {
-            double currE = f(sol);
-
-            // // swap two cities randomly
-            // int idx1 = dis(gen);
-            // int idx2 = (idx1 + 1) % numCities;
+            // if pass accept and check if it's a best solution
+            if (step(sol, currE, temp, d, moves, gen))
+            {
+                if (currE < bestDist)
+                {
+                    bestDist = currE;
+                    bestPath = sol.order();
+                }
+            }
 
-            // swap(sol[idx1], sol[idx2]);
+            history.push_back({temp, bestDist});
 
-            int idx1 = dist(gen);
-            int idx2;
-            do
-            {
-                idx2 = dist(gen);
-            } while (idx1 == idx2);
+            temp *= coolFactor;
+        }
 
-            if (idx1 > idx2)
-                swap(idx1, idx2);
+        // the running sum drifts a little, report the exact length
+        return Solution{bestPath, history, f(bestPath), {}};
+    }
 
-            vector<int> test_sol = sol;
-            reverse(test_sol.begin() + idx1, test_sol.begin() + idx2 + 1);
+    // Parallel tempering: numReplicas chains at fixed temperatures spaced
+    // geometrically from tMin to tMax, spread over numThreads threads.
+    // Each round every chain makes stepsPerRound moves, then neighbouring
+    // rungs (even pairs, then odd pairs on the next round) swap their
+    // tours with probability min(1, exp((1/T_i - 1/T_j)(E_i - E_j))):
+    // good tours drift to the cold end while the hot chains keep
+    // escaping local minima. history holds (round, best distance). Every
+    // chain has its own generator derived from seed, so the result does
+    // not depend on numThreads.
+    template <typename Tour = tsp::ArrayTour, typename F, typename D>
+    Solution solveTempering(vector<int> start, F f, D d, double tMin, double tMax, int numReplicas,
+                            int rounds, int stepsPerRound, tsp::Neighbourhood moves = tsp::TWO_OPT,
+                            uint64_t seed = random_device{}(),
+                            int numThreads = max(1u, thread::hardware_concurrency()))
+    {
+        struct Chain
+        {
+            Tour tour;
+            double energy;
+            double bestDist;
+            vector<int> bestPath;
+            mt19937_64 gen;
+        };
+
+        numReplicas = max(1, numReplicas);
+        numThreads = max(1, min(numThreads, numReplicas));
+
+        vector<Chain> chains;
+        vector<ReplicaStats> stats(numReplicas);
+        vector<int> chainAt(numReplicas); // chainAt[rung] = chain at that temperature
+        for (int r = 0; r < numReplicas; ++r)
+        {
+            double t = numReplicas == 1 ? 0.0 : (double)r / (numReplicas - 1);
+            stats[r].temperature = tMin * pow(tMax / tMin, t);
+            chains.push_back(Chain{Tour(start), f(start), f(start), start, mt19937_64(multistart::seedFor(seed, r))});
+            chainAt[r] = r;
+        }
 
-            double neighE = f(test_sol);
-            double deltaE = neighE - currE;
+        vector<pair<double, double>> history;
+        mt19937_64 swapGen(multistart::seedFor(seed, numReplicas));
+        uniform_real_distribution<double> distProb(0.0, 1.0);
+        Barrier barrier(numThreads);
 
-            // if pass accept and check if it's a best solution
-            if (deltaE < 0 || distProb(gen) < exp(-deltaE / temp))
+        auto worker = [&](int t)
+        {
+            for (int round = 0; round < rounds; ++round)
             {
-                double currDist = neighE;
-                sol = test_sol;
-                if (currDist < bestDist)
+                for (int r = t; r < numReplicas; r += numThreads)
+                {
+                    Chain &c = chains[chainAt[r]];
+                    for (int s = 0; s < stepsPerRound; ++s)
+                    {
+                        stats[r].proposed++;
+                        if (step(c.tour, c.energy, stats[r].temperature, d, moves, c.gen))
+                        {
+                            stats[r].accepted++;
+                            if (c.energy < c.bestDist)
+                            {
+                                c.bestDist = c.energy;
+                                c.bestPath = c.tour.order();
+                            }
+                        }
+                    }
+                }
+                barrier.wait();
+
+                if (t == 0)
                 {
-                    bestDist = currDist;
-                    bestPath = test_sol;
+                    for (int r = round % 2; r + 1 < numReplicas; r += 2)
+                    {
+                        Chain &cold = chains[chainAt[r]], &hot = chains[chainAt[r + 1]];
+                        double x = (1.0 / stats[r].temperature - 1.0 / stats[r + 1].temperature) * (cold.energy - hot.energy);
+                        stats[r].swapsTried++;
+                        if (x >= 0 || distProb(swapGen) < exp(x))
+                        {
+                            swap(chainAt[r], chainAt[r + 1]);
+                            stats[r].swapsAccepted++;
+                        }
+                    }
+
+                    double best = chains[0].bestDist;
+                    for (const Chain &c : chains)
+                        best = min(best, c.bestDist);
+                    history.push_back({(double)round, best});
                 }
+                barrier.wait();
             }
-            // else
-            // {
-            //     // swap it back
-            //     swap(sol[idx1], sol[idx2]);
-            // }
+        };
 
-            history.push_back({temp, bestDist});
+        vector<thread> workers;
+        for (int t = 1; t < numThreads; ++t)
+            workers.emplace_back(worker, t);
+        worker(0);
+        for (thread &w : workers)
+            w.join();
 
-            temp *= coolFactor;
-        }
-        return Solution{bestPath, history, bestDist};
+        const Chain *best = &chains[0];
+        for (const Chain &c : chains)
+            if (c.bestDist < best->bestDist)
+                best = &c;
+
+        return Solution{best->bestPath, history, f(best->bestPath), stats};
     }
 };
 
@@ -191,60 +307,129 @@ void printPath(const vector<int> &path)
     cout << path[0] + 1 << endl;
 }
 
-int main()
+// the restarts with distances from dist: a DistMatrix, or a DistOracle
+// when n x n doubles would not fit
+template <typename Dist>
+Solution solveAll(const Dist &dist, const vector<Point> &coords, tsp::Construction start, tsp::Neighbourhood moves,
+                  bool twoLevel, bool tempering, uint64_t masterSeed)
 {
-    string filename = "data/TSP Matrix.csv";
-    vector<Point> coordsCities = loadCoords(filename);
-    int nCities = coordsCities.size();
 
-    auto euclideanDistance = [](Point x, Point y)
+    auto D = [&](int u, int v)
     {
-        return sqrt(pow((x.X - y.X), 2) + pow((x.Y - y.Y), 2));
+        return dist(u, v);
     };
 
-    vector<vector<double>>
-        distMat = calcDist(coordsCities, euclideanDistance);
-
     auto F = [&](const vector<int> &path)
     {
-        double totDist = 0;
-        int n = path.size();
+        return tsp::tourLength(path, D);
+    };
 
-        for (size_t i = 0; i < n; ++i)
+    double tmax = 10.0;
+    double tmin = 0.0005;
+    double coolingRatio = 0.995;
+    SA solver;
+
+    // independent restarts on all cores, each from its own start tour; the
+    // seeds come from the master seed, so a run can be repeated exactly.
+    // Tempering already uses every core for its chains and runs once
+    int numRuns = tempering ? 1 : 8;
+    tsp::CandidateLists cand(coords, 8);
+    auto restart = [&](int, uint64_t seed)
+    {
+        mt19937_64 rng(seed);
+        vector<int> cities = tsp::initialTour(coords, cand, start, rng);
+
+        Solution sol;
+        if (tempering)
         {
-            int u = path[i];
-            int v = path[(i + 1) % n];
-            if (u == v)
-                continue;
-            int startNode = min(u, v);
-            int endNode = max(u, v);
-
-            totDist += distMat[startNode][endNode - startNode - 1];
+            // 8 rungs from 0.01 to 2, 2000 exchange rounds of 100 moves each
+            sol = twoLevel ? solver.solveTempering<tsp::TwoLevelTour>(cities, F, D, 0.01, 2.0, 8, 2000, 100, moves, seed)
+                           : solver.solveTempering(cities, F, D, 0.01, 2.0, 8, 2000, 100, moves, seed);
+        }
+        else
+        {
+            sol = twoLevel ? solver.solve<tsp::TwoLevelTour>(cities, F, D, tmax, tmin, coolingRatio, moves, seed)
+                           : solver.solve(cities, F, D, tmax, tmin, coolingRatio, moves, seed);
         }
 
-        return totDist;
+        // with lk the chains draw its building blocks, Or-opt and 2-opt, at
+        // random; the best tour is then taken down to an LK local optimum
+        if (moves == tsp::LIN_KERNIGHAN)
+        {
+            if (twoLevel)
+                tsp::LocalSearch<decltype(D), tsp::TwoLevelTour>(cand, D, moves).optimise(sol.path);
+            else
+                tsp::LocalSearch<decltype(D)>(cand, D, moves).optimise(sol.path);
+            sol.distance = F(sol.path);
+        }
+        return sol;
+    };
+    auto distance = [](const Solution &sol)
+    {
+        return sol.distance;
     };
 
-    // Initialise the vector of cities IDs
-    vector<int> cities(nCities);
-    iota(cities.begin(), cities.end(), 0);
+    multistart::Outcome<Solution> outcome = multistart::solve(numRuns, masterSeed, restart, distance);
+    for (int i = 0; i < numRuns; ++i)
+        cout << "Run " << i << ": cost " << outcome.costs[i] << endl;
+    cout << "Best run: " << outcome.bestRun << " (seed " << outcome.bestSeed << ")" << endl;
+    return outcome.best;
+}
 
-    random_device dev;
-    mt19937 rng(dev());
+// ./sa [2opt|oropt|or2opt|lk] [array|twolevel] [sa|pt] [seed]
+// [random|nn|greedy|sfc|christofides] picks the neighbourhood and the tour
+// representation, 2-opt on an array by default (lk anneals with Or-opt and
+// 2-opt and ends every run with an LK descent); pt runs parallel tempering
+// instead of cooling chains, seed is the master seed of the restarts and
+// the last argument the start tour, a shuffle by default (a built tour
+// only survives a start temperature well below the edge lengths)
+int main(int argc, char **argv)
+{
+    tsp::Neighbourhood moves = tsp::TWO_OPT;
+    if (argc > 1 && !tsp::parseNeighbourhood(argv[1], moves))
+    {
+        cerr << "Unknown neighbourhood: " << argv[1] << endl;
+        return 1;
+    }
+    bool twoLevel = argc > 2 && string(argv[2]) == "twolevel";
+    if (argc > 2 && !twoLevel && string(argv[2]) != "array")
+    {
+        cerr << "Unknown tour representation: " << argv[2] << endl;
+        return 1;
+    }
+    bool tempering = argc > 3 && string(argv[3]) == "pt";
+    if (argc > 3 && !tempering && string(argv[3]) != "sa")
+    {
+        cerr << "Unknown mode: " << argv[3] << endl;
+        return 1;
+    }
+    uint64_t masterSeed = 2024;
+    if (argc > 4)
+    {
+        char *end = nullptr;
+        masterSeed = strtoull(argv[4], &end, 10);
+        if (*argv[4] == '\0' || *end != '\0')
+        {
+            cerr << "Invalid seed: " << argv[4] << endl;
+            return 1;
+        }
+    }
+    tsp::Construction start = tsp::RANDOM_TOUR;
+    if (argc > 5 && !tsp::parseConstruction(argv[5], start))
+    {
+        cerr << "Unknown start tour: " << argv[5] << endl;
+        return 1;
+    }
 
-    // start from random path
-    shuffle(begin(cities), end(cities), rng);
-    cout << "Starting path: " << endl;
-    for (auto const &x : cities)
-        cout << x << "->";
-    cout << cities[0] << endl;
-    cout << "Initial cost: " << F(cities) << endl;
+    string filename = "data/TSP Matrix.csv";
+    vector<Point> coordsCities = loadCoords(filename);
 
-    double tmax = 10.0;
-    double tmin = 0.0005;
-    double coolingRatio = 0.995;
-    SA solver;
-    Solution sol = solver.solve(cities, F, tmax, tmin, coolingRatio);
+    // Euclidean distances computed once up to 20k cities (3.2 GB), on
+    // demand above that
+    const int MAX_MATRIX_CITIES = 20000;
+    Solution sol = coordsCities.size() <= (size_t)MAX_MATRIX_CITIES
+                       ? solveAll(DistMatrix(coordsCities), coordsCities, start, moves, twoLevel, tempering, masterSeed)
+                       : solveAll(DistOracle(coordsCities), coordsCities, start, moves, twoLevel, tempering, masterSeed);
 
     cout << "Found solution: " << endl;
     for (auto const &x : sol.path)
@@ -252,6 +437,12 @@ int main()
     cout << sol.path[0] << endl;
     cout << "Final cost = " << sol.distance << endl;
 
+    for (const ReplicaStats &r : sol.replicas)
+    {
+        cout << "T = " << r.temperature << ": accepted " << r.accepted << "/" << r.proposed
+             << " moves, " << r.swapsAccepted << "/" << r.swapsTried << " swaps up" << endl;
+    }
+
     saveHistory("results/sa_history.csv", sol.history);
     savePath("results/sa_final_path.csv", sol.path, coordsCities);
 
@@ -0,0 +1,407 @@
+/*
+Simple implementation of Simplified Memory-bounded A* (SMA*)
+
+SMA* behaves like A* until the number of nodes kept in memory reaches
+a hard budget. At that point the shallowest leaf with the highest f is
+dropped and its f-value is backed up into its parent, so the parent
+knows how good the forgotten subtree was and can regenerate it later
+if everything else turns out to be worse.
+
+Successors are generated one at a time, so the budget is never
+exceeded. A path is found whenever the shallowest optimal solution
+fits in the budget, and it is optimal if the heuristic is admissible.
+*/
+
+#include <vector>
+#include <utility>
+#include <set>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <limits.h>
+
+using namespace std;
+
+struct Node
+{
+    int id;
+    Node *next;
+    int f;
+    int g;
+};
+
+struct SMAStats
+{
+    long long generated = 0;   // successors created (including regenerations)
+    long long regenerated = 0; // successors that had been dropped before
+    long long dropped = 0;     // leaves removed because the budget was hit
+    int peakNodes = 0;         // maximum number of tree nodes held at once
+};
+
+class SMAStar
+{
+private:
+    struct TreeNode
+    {
+        int id;
+        int g;
+        int f;
+        int depth;
+        long long seq; // insertion order, used to break ties in open
+        TreeNode *parent;
+        int slot; // index of this node in parent->children
+
+        vector<TreeNode *> children; // one slot per edge in adj[id], nullptr if not in memory
+        vector<int> forgotten;       // backed-up f of dropped children, INT_MAX if none
+        int generated = 0;           // slots generated at least once
+        int inMemory = 0;            // children currently in memory
+        bool inOpen = false;
+    };
+
+    // best node first: lowest f, then deepest, then newest
+    struct ByPriority
+    {
+        bool operator()(const TreeNode *a, const TreeNode *b) const
+        {
+            if (a->f != b->f)
+                return a->f < b->f;
+            if (a->depth != b->depth)
+                return a->depth > b->depth;
+            return a->seq > b->seq;
+        }
+    };
+
+    set<TreeNode *, ByPriority> open;
+    int used = 0;
+    long long seq = 0;
+    SMAStats stats;
+
+    static int addCost(int a, int b)
+    {
+        if (a == INT_MAX || b == INT_MAX)
+            return INT_MAX;
+        return a + b;
+    }
+
+    void pushOpen(TreeNode *node)
+    {
+        if (!node->inOpen)
+        {
+            open.insert(node);
+            node->inOpen = true;
+        }
+    }
+
+    void popOpen(TreeNode *node)
+    {
+        if (node->inOpen)
+        {
+            open.erase(node);
+            node->inOpen = false;
+        }
+    }
+
+    void setF(TreeNode *node, int f)
+    {
+        // the set is ordered by f, so the node must be re-inserted
+        bool wasOpen = node->inOpen;
+        popOpen(node);
+        node->f = f;
+        if (wasOpen)
+            pushOpen(node);
+    }
+
+    // next successor slot to generate: a fresh one first, otherwise the
+    // forgotten one with the lowest backed-up f. -1 if there is none
+    int nextSlot(const TreeNode *node) const
+    {
+        if (node->generated < (int)node->children.size())
+            return node->generated;
+
+        int best = -1;
+        for (size_t i = 0; i < node->children.size(); ++i)
+        {
+            if (node->children[i] == nullptr && node->forgotten[i] != INT_MAX)
+            {
+                if (best == -1 || node->forgotten[i] < node->forgotten[best])
+                    best = i;
+            }
+        }
+        return best;
+    }
+
+    // leaves must stay in open so they can be dropped, inner nodes only
+    // while they still have successors to (re)generate
+    void refreshOpen(TreeNode *node)
+    {
+        if (node->inMemory == 0 || nextSlot(node) != -1)
+            pushOpen(node);
+        else
+            popOpen(node);
+    }
+
+    // once every successor has been seen, f(n) is the best f below n
+    void backup(TreeNode *node)
+    {
+        while (node != nullptr && node->generated == (int)node->children.size())
+        {
+            int best = INT_MAX;
+            for (size_t i = 0; i < node->children.size(); ++i)
+            {
+                int childF = node->children[i] ? node->children[i]->f : node->forgotten[i];
+                best = min(best, childF);
+            }
+
+            if (best <= node->f)
+                return;
+
+            setF(node, best);
+            node = node->parent;
+        }
+    }
+
+    bool onPath(const TreeNode *node, int id) const
+    {
+        for (; node != nullptr; node = node->parent)
+        {
+            if (node->id == id)
+                return true;
+        }
+        return false;
+    }
+
+    void dropWorstLeaf(const TreeNode *keep)
+    {
+        // worst leaf: highest f, then shallowest
+        for (auto it = open.rbegin(); it != open.rend(); ++it)
+        {
+            TreeNode *leaf = *it;
+            if (leaf->inMemory != 0 || leaf->parent == nullptr || leaf == keep)
+                continue;
+
+            popOpen(leaf);
+            TreeNode *parent = leaf->parent;
+            parent->children[leaf->slot] = nullptr;
+            parent->forgotten[leaf->slot] = leaf->f;
+            parent->inMemory--;
+            delete leaf;
+            used--;
+            stats.dropped++;
+
+            refreshOpen(parent);
+            return;
+        }
+    }
+
+    void deleteTree(TreeNode *node)
+    {
+        for (TreeNode *child : node->children)
+        {
+            if (child != nullptr)
+                deleteTree(child);
+        }
+        delete node;
+    }
+
+    TreeNode *newTreeNode(int id, int g, int depth, TreeNode *parent, int slot, int degree)
+    {
+        TreeNode *node = new TreeNode{id, g, 0, depth, seq++, parent, slot,
+                                      vector<TreeNode *>(degree, nullptr), vector<int>(degree, INT_MAX)};
+        used++;
+        stats.peakNodes = max(stats.peakNodes, used);
+        return node;
+    }
+
+public:
+    // adj holds (neigh_idx, cost) edges, h(i, T) must be admissible and
+    // maxNodes is the hard limit on the number of nodes kept in memory
+    template <typename Heuristic>
+    Node *findPath(vector<vector<pair<int, int>>> &adj, int S, int T, Heuristic h, int maxNodes)
+    {
+        open.clear();
+        used = 0;
+        seq = 0;
+        stats = SMAStats{};
+
+        if (S == T)
+            return new Node{S, nullptr, 0, 0};
+        if (maxNodes < 2)
+            return nullptr;
+
+        TreeNode *root = newTreeNode(S, 0, 0, nullptr, -1, adj[S].size());
+        root->f = h(S, T);
+        pushOpen(root);
+
+        TreeNode *goal = nullptr;
+        while (!open.empty())
+        {
+            TreeNode *best = *open.begin();
+            if (best->f == INT_MAX)
+                break; // nothing reachable within the budget
+
+            if (best->id == T)
+            {
+                goal = best;
+                break;
+            }
+
+            int slot = nextSlot(best);
+            if (slot == -1)
+            {
+                // dead end: it keeps f = INT_MAX until dropped
+                setF(best, INT_MAX);
+                backup(best->parent);
+                continue;
+            }
+
+            bool fresh = slot == best->generated;
+            if (fresh)
+                best->generated++;
+            else
+                stats.regenerated++;
+
+            int neigh_idx = adj[best->id][slot].first;
+            int neigh_g = adj[best->id][slot].second;
+
+            if (onPath(best, neigh_idx))
+            {
+                // cycles never lead to a better path
+                best->forgotten[slot] = INT_MAX;
+            }
+            else
+            {
+                // make room first, without forgetting the node being expanded
+                if (used == maxNodes)
+                    dropWorstLeaf(best);
+
+                TreeNode *child = newTreeNode(neigh_idx, best->g + neigh_g, best->depth + 1,
+                                              best, slot, adj[neigh_idx].size());
+                stats.generated++;
+
+                // a non-goal node at maximum depth can never reach the goal
+                // without exceeding the budget
+                if (neigh_idx != T && child->depth >= maxNodes - 1)
+                    child->f = INT_MAX;
+                else
+                    child->f = max(best->f, addCost(child->g, h(neigh_idx, T))); // pathmax
+
+                best->children[slot] = child;
+                best->forgotten[slot] = INT_MAX;
+                best->inMemory++;
+                pushOpen(child);
+            }
+
+            backup(best);
+            refreshOpen(best);
+        }
+
+        Node *head = nullptr;
+        if (goal != nullptr)
+        {
+            for (TreeNode *curr = goal; curr != nullptr; curr = curr->parent)
+                head = new Node{curr->id, head, curr->f, curr->g};
+        }
+
+        open.clear();
+        deleteTree(root);
+        used = 0;
+        return head;
+    }
+
+    const SMAStats &lastStats() const
+    {
+        return stats;
+    }
+
+    void printPath(Node *head)
+    {
+        if (head == nullptr)
+            return;
+
+        while (head->next != nullptr)
+        {
+            cout << head->id << ", " << head->g << "->";
+            head = head->next;
+        }
+        cout << head->id << ", " << head->g << endl;
+    }
+
+    void deletePath(Node *head)
+    {
+        if (head == nullptr)
+            return;
+
+        Node *curr = head;
+        while (curr->next != nullptr)
+        {
+            Node *nextNode = curr->next;
+            delete curr;
+            curr = nextNode;
+        }
+        delete curr;
+    }
+};
+
+struct Point
+{
+    int x;
+    int y;
+};
+
+int main()
+{
+    // 6x6 grid with unit costs and a wall in column 3 (open at the bottom)
+    int side = 6;
+    vector<Point> coords;
+    vector<vector<pair<int, int>>> adj(side * side);
+    auto blocked = [&](int x, int y)
+    { return x == 3 && y < side - 1; };
+
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            coords.push_back({x, y});
+            if (blocked(x, y))
+                continue;
+
+            int dx[] = {1, -1, 0, 0};
+            int dy[] = {0, 0, 1, -1};
+            for (int k = 0; k < 4; ++k)
+            {
+                int nx = x + dx[k];
+                int ny = y + dy[k];
+                if (nx < 0 || ny < 0 || nx >= side || ny >= side || blocked(nx, ny))
+                    continue;
+                adj[y * side + x].push_back({ny * side + nx, 1});
+            }
+        }
+    }
+
+    auto manhattan = [&coords](int i, int j)
+    {
+        return abs(coords[i].x - coords[j].x) + abs(coords[i].y - coords[j].y);
+    };
+
+    SMAStar solver;
+    int S = 0;
+    int T = side - 1;
+
+    for (int budget : {1000, 40, 20, 16})
+    {
+        Node *path = solver.findPath(adj, S, T, manhattan, budget);
+        const SMAStats &stats = solver.lastStats();
+
+        cout << "Budget " << budget << " nodes: ";
+        if (path)
+            solver.printPath(path);
+        else
+            cout << "no path within budget" << endl;
+        cout << "  generated " << stats.generated << ", regenerated " << stats.regenerated
+             << ", dropped " << stats.dropped << ", peak " << stats.peakNodes << endl;
+
+        solver.deletePath(path);
+    }
+
+    return 0;
+}
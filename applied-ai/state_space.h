@@ -0,0 +1,257 @@
+/*
+Building blocks for implicit state spaces
+
+Puzzles and planning problems are searched without ever building adj:
+a Problem generates the successors of a state on demand.
+
+  typedef ... State;                              PackedState, or any type with == and hash()
+  typedef ... Cost;                               integral
+  State start() const;
+  bool isGoal(const State &) const;
+  Cost heuristic(const State &) const;
+  void successors(const State &, vector<pair<State, Cost>> &) const;
+  size_t hash(const State &) const;
+
+This is the same interface HDAStar (hdastar.cpp) uses, so every Problem
+here also runs on it unchanged.
+
+  PackedState<Bits, Count>  Count fields of Bits bits in one uint64, e.g.
+                            4 bits per tile for the 15-puzzle
+  StateTable<State, Value>  open-addressing hash table (linear probing,
+                            power of two capacity) for closed lists
+  SlidingTilePuzzle<Side>   the (Side*Side - 1)-puzzle with the Manhattan
+                            distance heuristic
+*/
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <algorithm>
+
+template <int Bits, int Count>
+struct PackedState
+{
+    static_assert(Bits * Count <= 64, "PackedState must fit in 64 bits");
+    static const uint64_t MASK = (Bits == 64) ? ~0ULL : ((1ULL << Bits) - 1);
+
+    uint64_t bits = 0;
+
+    unsigned get(int i) const
+    {
+        return (bits >> (i * Bits)) & MASK;
+    }
+
+    void set(int i, unsigned value)
+    {
+        bits = (bits & ~(MASK << (i * Bits))) | ((uint64_t)value << (i * Bits));
+    }
+
+    bool operator==(const PackedState &o) const { return bits == o.bits; }
+    bool operator!=(const PackedState &o) const { return bits != o.bits; }
+    bool operator<(const PackedState &o) const { return bits < o.bits; }
+
+    // splitmix64 finaliser, neighbouring states differ in a few bits only
+    size_t hash() const
+    {
+        uint64_t z = bits + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+};
+
+template <typename State, typename Value>
+class StateTable
+{
+public:
+    explicit StateTable(size_t expected = 1024)
+    {
+        size_t capacity = 16;
+        while (capacity * MAX_LOAD_NUM < expected * MAX_LOAD_DEN)
+            capacity *= 2;
+        allocate(capacity);
+    }
+
+    // nullptr if the state is not in the table
+    Value *find(const State &s)
+    {
+        size_t i = s.hash() & mask;
+        while (used[i])
+        {
+            if (keys[i] == s)
+                return &values[i];
+            i = (i + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    // (slot, true) if the state was inserted with value, (slot, false) if
+    // it was already there. The pointer is valid until the next insert
+    std::pair<Value *, bool> insert(const State &s, const Value &value)
+    {
+        if ((count + 1) * MAX_LOAD_DEN > keys.size() * MAX_LOAD_NUM)
+            grow();
+
+        size_t i = s.hash() & mask;
+        while (used[i])
+        {
+            if (keys[i] == s)
+                return {&values[i], false};
+            i = (i + 1) & mask;
+        }
+        used[i] = 1;
+        keys[i] = s;
+        values[i] = value;
+        count++;
+        return {&values[i], true};
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    void clear()
+    {
+        std::fill(used.begin(), used.end(), 0);
+        count = 0;
+    }
+
+    size_t memoryBytes() const
+    {
+        return keys.capacity() * sizeof(State) + values.capacity() * sizeof(Value) + used.capacity();
+    }
+
+private:
+    // grow past 3/4 full, linear probing degrades quickly after that
+    static const size_t MAX_LOAD_NUM = 3;
+    static const size_t MAX_LOAD_DEN = 4;
+
+    std::vector<State> keys;
+    std::vector<Value> values;
+    std::vector<char> used;
+    size_t mask = 0;
+    size_t count = 0;
+
+    void allocate(size_t capacity)
+    {
+        keys.assign(capacity, State());
+        values.assign(capacity, Value());
+        used.assign(capacity, 0);
+        mask = capacity - 1;
+        count = 0;
+    }
+
+    void grow()
+    {
+        std::vector<State> oldKeys;
+        std::vector<Value> oldValues;
+        std::vector<char> oldUsed;
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        oldUsed.swap(used);
+
+        allocate(oldKeys.size() * 2);
+        for (size_t i = 0; i < oldKeys.size(); ++i)
+        {
+            if (oldUsed[i])
+                insert(oldKeys[i], oldValues[i]);
+        }
+    }
+};
+
+// the (Side*Side - 1)-puzzle, tile 0 is the blank. The goal has the blank
+// in cell 0 and tile t in cell t
+template <int Side>
+class SlidingTilePuzzle
+{
+public:
+    static const int CELLS = Side * Side;
+    typedef PackedState<4, CELLS> State;
+    typedef int Cost;
+
+    explicit SlidingTilePuzzle(const std::vector<int> &tiles)
+    {
+        for (int cell = 0; cell < CELLS; ++cell)
+        {
+            initial.set(cell, tiles[cell]);
+            goal.set(cell, cell);
+        }
+    }
+
+    State start() const
+    {
+        return initial;
+    }
+
+    bool isGoal(const State &s) const
+    {
+        return s == goal;
+    }
+
+    Cost heuristic(const State &s) const
+    {
+        int total = 0;
+        for (int cell = 0; cell < CELLS; ++cell)
+        {
+            int tile = s.get(cell);
+            if (tile != 0)
+                total += std::abs(cell / Side - tile / Side) + std::abs(cell % Side - tile % Side);
+        }
+        return total;
+    }
+
+    void successors(const State &s, std::vector<std::pair<State, Cost>> &out) const
+    {
+        int blank = blankCell(s);
+        int row = blank / Side, col = blank % Side;
+        static const int dr[] = {-1, 1, 0, 0}, dc[] = {0, 0, -1, 1};
+        for (int k = 0; k < 4; ++k)
+        {
+            int r = row + dr[k], c = col + dc[k];
+            if (r < 0 || c < 0 || r >= Side || c >= Side)
+                continue;
+
+            // slide the tile at (r, c) into the blank
+            int cell = r * Side + c;
+            State next = s;
+            next.set(blank, s.get(cell));
+            next.set(cell, 0);
+            out.push_back({next, 1});
+        }
+    }
+
+    size_t hash(const State &s) const
+    {
+        return s.hash();
+    }
+
+    static int blankCell(const State &s)
+    {
+        for (int cell = 0; cell < CELLS; ++cell)
+        {
+            if (s.get(cell) == 0)
+                return cell;
+        }
+        return -1;
+    }
+
+    static std::string toString(const State &s)
+    {
+        std::string out;
+        for (int cell = 0; cell < CELLS; ++cell)
+        {
+            out += std::to_string(s.get(cell));
+            out += (cell % Side == Side - 1) ? (cell == CELLS - 1 ? "" : " / ") : " ";
+        }
+        return out;
+    }
+
+private:
+    State initial;
+    State goal;
+};
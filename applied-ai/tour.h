@@ -0,0 +1,323 @@
+/*
+Tour representations for the TSP local searches
+
+Both classes keep a cyclic order of the cities 0 .. n-1 behind the same
+interface, so solvers can be written once and switched with a template
+argument:
+
+  next(c), prev(c)      neighbours of c in the current direction
+  between(a, b, c)      b lies on the way from a forward to c (inclusive)
+  flip(a, b, c, d)      with b = next(a) and d = next(c): removes the
+                        edges (a, b) and (c, d) and adds (a, c) and (b, d),
+                        i.e. reverses the path b .. c
+  order()               the cities as a vector<int>, in tour order
+
+A flip may reverse the rest of the tour (d .. a) instead of b .. c when
+that is shorter. The cycle is the same but the direction of travel flips
+with it, so after a flip next(a) is not necessarily c: look neighbours up
+again instead of assuming an orientation (move2 below does this).
+
+  ArrayTour     the order and a position index; flips cost up to n / 2
+  TwoLevelTour  the order cut into blocks of about sqrt(n) cities, each
+                with a reversed bit. A flip splits at most two blocks and
+                reverses the sequence of blocks between them, O(sqrt(n));
+                when splits have made too many blocks they are rebuilt
+                evenly, O(n) every O(sqrt(n)) flips
+*/
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+namespace tsp
+{
+    class ArrayTour
+    {
+    public:
+        ArrayTour() = default;
+
+        explicit ArrayTour(const std::vector<int> &order) : cities(order), pos(order.size())
+        {
+            for (int i = 0; i < (int)cities.size(); ++i)
+                pos[cities[i]] = i;
+        }
+
+        int size() const
+        {
+            return cities.size();
+        }
+
+        int next(int c) const
+        {
+            int p = pos[c] + 1;
+            return cities[p == size() ? 0 : p];
+        }
+
+        int prev(int c) const
+        {
+            int p = pos[c] - 1;
+            return cities[p < 0 ? size() - 1 : p];
+        }
+
+        bool between(int a, int b, int c) const
+        {
+            int pa = pos[a], pb = pos[b], pc = pos[c];
+            return pa <= pc ? pa <= pb && pb <= pc : pb >= pa || pb <= pc;
+        }
+
+        void flip(int a, int b, int c, int d)
+        {
+            int n = size();
+            int inside = (pos[c] - pos[b] + n) % n + 1;
+            if (2 * inside <= n)
+                reverse(pos[b], pos[c]);
+            else
+                reverse(pos[d], pos[a]);
+        }
+
+        std::vector<int> order() const
+        {
+            return cities;
+        }
+
+    private:
+        std::vector<int> cities;
+        std::vector<int> pos;
+
+        // positions i forward to j, wrapping around the end of the array
+        void reverse(int i, int j)
+        {
+            int n = size();
+            int len = (j - i + n) % n + 1;
+            for (int s = 0; s < len / 2; ++s)
+            {
+                int a = i + s >= n ? i + s - n : i + s;
+                int b = j - s < 0 ? j - s + n : j - s;
+                std::swap(cities[a], cities[b]);
+                pos[cities[a]] = a;
+                pos[cities[b]] = b;
+            }
+        }
+    };
+
+    class TwoLevelTour
+    {
+    public:
+        TwoLevelTour() = default;
+
+        explicit TwoLevelTour(const std::vector<int> &order)
+            : n(order.size()), blockOf(order.size()), index(order.size())
+        {
+            rebuild(order);
+        }
+
+        int size() const
+        {
+            return n;
+        }
+
+        int next(int c) const
+        {
+            const Block &b = blocks[blockOf[c]];
+            int l = local(c) + 1;
+            if (l < (int)b.cities.size())
+                return at(b, l);
+            return at(blocks[sequence[wrap(rank[blockOf[c]] + 1)]], 0);
+        }
+
+        int prev(int c) const
+        {
+            const Block &b = blocks[blockOf[c]];
+            int l = local(c) - 1;
+            if (l >= 0)
+                return at(b, l);
+            const Block &p = blocks[sequence[wrap(rank[blockOf[c]] - 1)]];
+            return at(p, p.cities.size() - 1);
+        }
+
+        bool between(int a, int b, int c) const
+        {
+            long long ka = key(a), kb = key(b), kc = key(c);
+            return ka <= kc ? ka <= kb && kb <= kc : kb >= ka || kb <= kc;
+        }
+
+        void flip(int a, int b, int c, int d)
+        {
+            if (b == d)
+                return; // b .. c is the whole tour: the same cycle backwards
+
+            // make b .. c and d .. a runs of whole blocks
+            splitBefore(b);
+            splitBefore(d);
+
+            int count = sequence.size();
+            int rb = rank[blockOf[b]], rc = rank[blockOf[c]];
+            int inside = (rc - rb + count) % count + 1;
+            if (2 * inside <= count)
+                reverseBlocks(rb, rc);
+            else
+                reverseBlocks(rank[blockOf[d]], rank[blockOf[a]]);
+
+            if ((int)sequence.size() > maxBlocks)
+                rebuild(order());
+        }
+
+        std::vector<int> order() const
+        {
+            std::vector<int> cities;
+            cities.reserve(n);
+            for (int id : sequence)
+            {
+                const Block &b = blocks[id];
+                if (b.reversed)
+                    cities.insert(cities.end(), b.cities.rbegin(), b.cities.rend());
+                else
+                    cities.insert(cities.end(), b.cities.begin(), b.cities.end());
+            }
+            return cities;
+        }
+
+    private:
+        struct Block
+        {
+            std::vector<int> cities; // stored order, read backwards if reversed
+            bool reversed = false;
+        };
+
+        int n = 0;
+        int maxBlocks = 0;
+        std::vector<Block> blocks;
+        std::vector<int> sequence; // block ids in tour order
+        std::vector<int> rank;     // rank[block] = its index in sequence
+        std::vector<int> blockOf;  // per city
+        std::vector<int> index;    // per city, in its block's stored order
+
+        int wrap(int r) const
+        {
+            int count = sequence.size();
+            return r < 0 ? r + count : r >= count ? r - count : r;
+        }
+
+        // position of c inside its block, in tour order
+        int local(int c) const
+        {
+            const Block &b = blocks[blockOf[c]];
+            return b.reversed ? (int)b.cities.size() - 1 - index[c] : index[c];
+        }
+
+        static int at(const Block &b, int l)
+        {
+            return b.reversed ? b.cities[b.cities.size() - 1 - l] : b.cities[l];
+        }
+
+        long long key(int c) const
+        {
+            return (long long)rank[blockOf[c]] * n + local(c);
+        }
+
+        void rebuild(const std::vector<int> &order)
+        {
+            int groupSize = std::max(8, (int)std::sqrt((double)n));
+            int count = std::max(1, (n + groupSize - 1) / groupSize);
+            maxBlocks = 3 * count + 2;
+
+            // every flip adds at most two blocks: reserving up front keeps
+            // references into blocks valid while splitting
+            blocks.resize(count);
+            blocks.reserve(maxBlocks + 2);
+            sequence.resize(count);
+            rank.resize(maxBlocks + 2);
+            for (int k = 0; k < count; ++k)
+            {
+                Block &b = blocks[k];
+                int first = k * groupSize, last = std::min(n, first + groupSize);
+                b.cities.assign(order.begin() + first, order.begin() + last);
+                b.reversed = false;
+                for (int i = 0; i < (int)b.cities.size(); ++i)
+                {
+                    blockOf[b.cities[i]] = k;
+                    index[b.cities[i]] = i;
+                }
+                sequence[k] = k;
+                rank[k] = k;
+            }
+        }
+
+        // makes c the first city of its block
+        void splitBefore(int c)
+        {
+            int l = local(c);
+            if (l == 0)
+                return;
+
+            int id = blockOf[c], fresh = blocks.size();
+            blocks.emplace_back();
+            Block &b = blocks[id], &tail = blocks[fresh];
+            int size = b.cities.size();
+
+            // tail takes the cities from c onwards in tour order
+            tail.reversed = b.reversed;
+            if (!b.reversed)
+            {
+                tail.cities.assign(b.cities.begin() + l, b.cities.end());
+                b.cities.resize(l);
+            }
+            else
+            {
+                tail.cities.assign(b.cities.begin(), b.cities.begin() + (size - l));
+                b.cities.erase(b.cities.begin(), b.cities.begin() + (size - l));
+                for (int i = 0; i < (int)b.cities.size(); ++i)
+                    index[b.cities[i]] = i;
+            }
+            for (int i = 0; i < (int)tail.cities.size(); ++i)
+            {
+                blockOf[tail.cities[i]] = fresh;
+                index[tail.cities[i]] = i;
+            }
+
+            sequence.insert(sequence.begin() + rank[id] + 1, fresh);
+            for (int r = rank[id] + 1; r < (int)sequence.size(); ++r)
+                rank[sequence[r]] = r;
+        }
+
+        // reverses the blocks from rank r1 forward to rank r2, wrapping
+        void reverseBlocks(int r1, int r2)
+        {
+            int count = sequence.size();
+            int len = (r2 - r1 + count) % count + 1;
+            for (int s = 0; s < len / 2; ++s)
+                std::swap(sequence[wrap(r1 + s)], sequence[wrap(r2 - s)]);
+            for (int s = 0; s < len; ++s)
+            {
+                int r = wrap(r1 + s);
+                blocks[sequence[r]].reversed = !blocks[sequence[r]].reversed;
+                rank[sequence[r]] = r;
+            }
+        }
+    };
+
+    // flip for edges known only up to direction: b follows a and e follows
+    // c, both forward or both backward
+    template <typename Tour>
+    void move2(Tour &tour, int a, int b, int c, int e)
+    {
+        if (tour.next(a) == b)
+            tour.flip(a, b, c, e);
+        else
+            tour.flip(e, c, b, a);
+    }
+
+    // p -> s1 .. s2 -> nx ... x -> y  becomes  p -> nx ... x -> [segment] -> y,
+    // the segment kept in order or reversed, as two or three 2-opt moves
+    template <typename Tour>
+    void moveSegment(Tour &tour, int p, int s1, int s2, int nx, int x, int y, bool reversed)
+    {
+        move2(tour, p, s1, x, y);  // p x ... nx s2 .. s1 y
+        move2(tour, p, x, nx, s2); // p nx ... x s2 .. s1 y
+        if (!reversed && s1 != s2)
+            move2(tour, x, s2, s1, y); // p nx ... x s1 .. s2 y
+    }
+}
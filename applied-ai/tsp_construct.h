@@ -0,0 +1,472 @@
+/*
+Construction heuristics for TSP start tours
+
+A shuffled start leaves the local search undoing a random tour, which on
+large instances is most of the run. These build a reasonable tour from
+the coordinates instead, using a uniform grid (PointGrid) or the
+candidate lists of tsp_local_search.h for the spatial queries:
+
+  NEAREST_NEIGHBOUR    from a start city always go to the closest city
+                       not yet visited (grid with removal)
+  GREEDY_EDGE          add the candidate edges shortest first, skipping
+                       any that would give a city degree 3 or close a
+                       cycle; the fragments left are then chained
+                       nearest end first
+  SPACE_FILLING_CURVE  the cities in Hilbert curve order
+  CHRISTOFIDES         Christofides with a greedy instead of a minimum
+                       weight matching: spanning tree on the candidate
+                       edges, the odd-degree cities paired nearest
+                       first, an Euler circuit of the union, shortcut
+
+On uniform random cities the tours come out roughly 25% (nearest
+neighbour), 15-20% (greedy), 25% (Christofides-lite) and 40% (curve)
+above optimal. The sorts make them O(n log n); the grid searches are
+O(1) expected per query for spread out cities, slower when the few
+cities left are far apart.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+#include "tsp_local_search.h"
+
+namespace tsp
+{
+    enum Construction
+    {
+        RANDOM_TOUR,
+        NEAREST_NEIGHBOUR,
+        GREEDY_EDGE,
+        SPACE_FILLING_CURVE,
+        CHRISTOFIDES
+    };
+
+    // "random", "nn", "greedy", "sfc" or "christofides"; false if unknown
+    inline bool parseConstruction(std::string_view name, Construction &out)
+    {
+        const std::pair<std::string_view, Construction> names[] = {
+            {"random", RANDOM_TOUR}, {"nn", NEAREST_NEIGHBOUR}, {"greedy", GREEDY_EDGE},
+            {"sfc", SPACE_FILLING_CURVE}, {"christofides", CHRISTOFIDES}};
+        for (const auto &[key, value] : names)
+        {
+            if (name == key)
+            {
+                out = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // a subset of the points in a uniform grid, about two per cell, that
+    // finds the closest remaining one and lets them be removed
+    template <typename P>
+    class PointGrid
+    {
+    public:
+        PointGrid(const std::vector<P> &points, const std::vector<int> &ids)
+            : points(points), slot(points.size(), -1), remaining(ids.size())
+        {
+            if (ids.empty())
+                return;
+
+            minX = maxX = points[ids[0]].X;
+            minY = maxY = points[ids[0]].Y;
+            for (int id : ids)
+            {
+                minX = std::min(minX, points[id].X);
+                maxX = std::max(maxX, points[id].X);
+                minY = std::min(minY, points[id].Y);
+                maxY = std::max(maxY, points[id].Y);
+            }
+            side = std::max(1, (int)std::sqrt(ids.size() / 2.0));
+            cellW = std::max((maxX - minX) / side, 1e-12);
+            cellH = std::max((maxY - minY) / side, 1e-12);
+
+            // counting sort by cell; count[c] of the items from start[c]
+            // are still in the grid
+            start.assign(side * side + 1, 0);
+            for (int id : ids)
+                start[cellOf(points[id].X, points[id].Y) + 1]++;
+            for (int c = 0; c < side * side; ++c)
+                start[c + 1] += start[c];
+            count.assign(side * side, 0);
+            items.resize(ids.size());
+            for (int id : ids)
+            {
+                int c = cellOf(points[id].X, points[id].Y);
+                slot[id] = start[c] + count[c];
+                items[slot[id]] = id;
+                count[c]++;
+            }
+        }
+
+        int size() const
+        {
+            return remaining;
+        }
+
+        void remove(int id)
+        {
+            if (slot[id] < 0)
+                return;
+            int c = cellOf(points[id].X, points[id].Y);
+            int last = items[start[c] + --count[c]];
+            items[slot[id]] = last;
+            slot[last] = slot[id];
+            slot[id] = -1;
+            remaining--;
+        }
+
+        // the remaining point closest to (x, y), -1 if none is left
+        int nearest(double x, double y) const
+        {
+            if (remaining == 0)
+                return -1;
+
+            int cx = std::clamp((int)((x - minX) / cellW), 0, side - 1);
+            int cy = std::clamp((int)((y - minY) / cellH), 0, side - 1);
+            double cellMin = std::min(cellW, cellH);
+            int best = -1;
+            double bestDist = 0.0;
+            for (int r = 0; r < side; ++r)
+            {
+                forEachRingCell(cx, cy, r, side, [&](int c)
+                                {
+                                    for (int s = start[c]; s < start[c] + count[c]; ++s)
+                                    {
+                                        const P &p = points[items[s]];
+                                        double dx = p.X - x, dy = p.Y - y;
+                                        double dist = dx * dx + dy * dy;
+                                        if (best < 0 || dist < bestDist)
+                                        {
+                                            best = items[s];
+                                            bestDist = dist;
+                                        }
+                                    }
+                                });
+                double reach = r * cellMin;
+                if (best >= 0 && bestDist <= reach * reach)
+                    break;
+            }
+            return best;
+        }
+
+    private:
+        const std::vector<P> &points;
+        std::vector<int> slot; // per point, its index in items or -1
+        std::vector<int> items, start, count;
+        int remaining;
+        int side = 1;
+        double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0, cellW = 1.0, cellH = 1.0;
+
+        int cellOf(double x, double y) const
+        {
+            int cx = std::clamp((int)((x - minX) / cellW), 0, side - 1);
+            int cy = std::clamp((int)((y - minY) / cellH), 0, side - 1);
+            return cy * side + cx;
+        }
+    };
+
+    namespace detail
+    {
+        template <typename P>
+        double distance(const std::vector<P> &points, int a, int b)
+        {
+            double dx = points[a].X - points[b].X, dy = points[a].Y - points[b].Y;
+            return std::sqrt(dx * dx + dy * dy);
+        }
+
+        // every candidate edge once, shortest first
+        template <typename P>
+        std::vector<std::pair<int, int>> sortedEdges(const std::vector<P> &points, const CandidateLists &cand)
+        {
+            std::vector<std::pair<int, int>> edges;
+            edges.reserve((size_t)points.size() * cand.k());
+            for (int i = 0; i < (int)points.size(); ++i)
+                for (const int *c = cand.begin(i); c != cand.end(i); ++c)
+                    edges.push_back({std::min(i, *c), std::max(i, *c)});
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            std::vector<double> length(edges.size());
+            std::vector<int> order(edges.size());
+            for (size_t e = 0; e < edges.size(); ++e)
+                length[e] = distance(points, edges[e].first, edges[e].second);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](int a, int b)
+                      { return length[a] < length[b]; });
+
+            std::vector<std::pair<int, int>> sorted(edges.size());
+            for (size_t e = 0; e < edges.size(); ++e)
+                sorted[e] = edges[order[e]];
+            return sorted;
+        }
+
+        struct UnionFind
+        {
+            std::vector<int> parent;
+
+            explicit UnionFind(int n) : parent(n)
+            {
+                std::iota(parent.begin(), parent.end(), 0);
+            }
+
+            int find(int a)
+            {
+                while (parent[a] != a)
+                    a = parent[a] = parent[parent[a]];
+                return a;
+            }
+
+            // false if a and b were already joined
+            bool join(int a, int b)
+            {
+                a = find(a);
+                b = find(b);
+                if (a == b)
+                    return false;
+                parent[a] = b;
+                return true;
+            }
+        };
+
+        // position along a Hilbert curve over a 2^16 x 2^16 grid
+        inline uint64_t hilbertIndex(uint32_t x, uint32_t y)
+        {
+            const uint32_t n = 1u << 16;
+            uint64_t d = 0;
+            for (uint32_t s = n / 2; s > 0; s /= 2)
+            {
+                uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+                d += (uint64_t)s * s * ((3 * rx) ^ ry);
+                if (ry == 0)
+                {
+                    if (rx == 1)
+                    {
+                        x = n - 1 - x;
+                        y = n - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return d;
+        }
+    }
+
+    template <typename P>
+    std::vector<int> nearestNeighbourTour(const std::vector<P> &points, int first = 0)
+    {
+        int n = points.size();
+        std::vector<int> tour;
+        if (n == 0)
+            return tour;
+        tour.reserve(n);
+
+        std::vector<int> all(n);
+        std::iota(all.begin(), all.end(), 0);
+        PointGrid<P> grid(points, all);
+
+        for (int c = first; c >= 0; c = grid.nearest(points[c].X, points[c].Y))
+        {
+            tour.push_back(c);
+            grid.remove(c);
+        }
+        return tour;
+    }
+
+    template <typename P>
+    std::vector<int> spaceFillingCurveTour(const std::vector<P> &points)
+    {
+        int n = points.size();
+        std::vector<int> tour(n);
+        std::iota(tour.begin(), tour.end(), 0);
+        if (n == 0)
+            return tour;
+
+        double minX = points[0].X, maxX = minX, minY = points[0].Y, maxY = minY;
+        for (const P &p : points)
+        {
+            minX = std::min(minX, p.X);
+            maxX = std::max(maxX, p.X);
+            minY = std::min(minY, p.Y);
+            maxY = std::max(maxY, p.Y);
+        }
+        // one scale for both axes keeps the curve's locality
+        double scale = 65535.0 / std::max({maxX - minX, maxY - minY, 1e-12});
+
+        std::vector<uint64_t> key(n);
+        for (int i = 0; i < n; ++i)
+            key[i] = detail::hilbertIndex((uint32_t)((points[i].X - minX) * scale),
+                                          (uint32_t)((points[i].Y - minY) * scale));
+        std::sort(tour.begin(), tour.end(), [&](int a, int b)
+                  { return key[a] < key[b]; });
+        return tour;
+    }
+
+    template <typename P>
+    std::vector<int> greedyEdgeTour(const std::vector<P> &points, const CandidateLists &cand)
+    {
+        int n = points.size();
+        std::vector<int> tour;
+        if (n == 0)
+            return tour;
+        tour.reserve(n);
+
+        // fragments: paths of the shortest edges that keep degrees <= 2
+        std::vector<std::pair<int, int>> adj(n, {-1, -1});
+        detail::UnionFind fragments(n);
+        for (auto [a, b] : detail::sortedEdges(points, cand))
+        {
+            if (adj[a].second >= 0 || adj[b].second >= 0 || !fragments.join(a, b))
+                continue;
+            (adj[a].first < 0 ? adj[a].first : adj[a].second) = b;
+            (adj[b].first < 0 ? adj[b].first : adj[b].second) = a;
+        }
+
+        // walk a fragment to its other end, then jump to the closest end
+        // of a fragment not yet in the tour
+        std::vector<int> ends;
+        for (int i = 0; i < n; ++i)
+            if (adj[i].second < 0)
+                ends.push_back(i);
+        PointGrid<P> grid(points, ends);
+
+        for (int c = ends[0]; c >= 0; c = grid.nearest(points[c].X, points[c].Y))
+        {
+            grid.remove(c);
+            for (int prev = -1, next; c >= 0; prev = c, c = next)
+            {
+                tour.push_back(c);
+                next = adj[c].first == prev ? adj[c].second : adj[c].first;
+                if (next < 0)
+                    break;
+            }
+            grid.remove(c);
+        }
+        return tour;
+    }
+
+    template <typename P>
+    std::vector<int> christofidesTour(const std::vector<P> &points, const CandidateLists &cand)
+    {
+        int n = points.size();
+        std::vector<int> tour;
+        if (n == 0)
+            return tour;
+        tour.reserve(n);
+
+        // spanning tree of the candidate graph, a forest if it is not
+        // connected
+        std::vector<std::pair<int, int>> edges;
+        std::vector<int> degree(n, 0);
+        detail::UnionFind trees(n);
+        for (auto [a, b] : detail::sortedEdges(points, cand))
+        {
+            if (trees.join(a, b))
+            {
+                edges.push_back({a, b});
+                degree[a]++;
+                degree[b]++;
+            }
+        }
+
+        // pair the odd-degree cities, each with the closest unpaired one;
+        // there is an even number of them
+        std::vector<int> odd;
+        for (int i = 0; i < n; ++i)
+            if (degree[i] % 2 == 1)
+                odd.push_back(i);
+        PointGrid<P> grid(points, odd);
+        std::vector<char> paired(n, 0);
+        for (int a : odd)
+        {
+            if (paired[a])
+                continue;
+            grid.remove(a);
+            int b = grid.nearest(points[a].X, points[a].Y);
+            grid.remove(b);
+            paired[a] = paired[b] = 1;
+            edges.push_back({a, b});
+        }
+
+        // every degree is now even: an Euler circuit of each connected
+        // part, skipping cities already in the tour
+        std::vector<int> first(n + 1, 0), incident(2 * edges.size());
+        for (auto [a, b] : edges)
+        {
+            first[a + 1]++;
+            first[b + 1]++;
+        }
+        for (int i = 0; i < n; ++i)
+            first[i + 1] += first[i];
+        std::vector<int> fill(first.begin(), first.end() - 1);
+        for (int e = 0; e < (int)edges.size(); ++e)
+        {
+            incident[fill[edges[e].first]++] = e;
+            incident[fill[edges[e].second]++] = e;
+        }
+
+        std::vector<char> used(edges.size(), 0), inTour(n, 0);
+        std::vector<int> next(first.begin(), first.end() - 1), stack;
+        for (int s = 0; s < n; ++s)
+        {
+            if (inTour[s])
+                continue;
+            stack.push_back(s);
+            while (!stack.empty())
+            {
+                int v = stack.back();
+                while (next[v] < first[v + 1] && used[incident[next[v]]])
+                    next[v]++;
+                if (next[v] == first[v + 1])
+                {
+                    stack.pop_back();
+                    if (!inTour[v])
+                    {
+                        inTour[v] = 1;
+                        tour.push_back(v);
+                    }
+                    continue;
+                }
+                int e = incident[next[v]];
+                used[e] = 1;
+                stack.push_back(edges[e].first == v ? edges[e].second : edges[e].first);
+            }
+        }
+        return tour;
+    }
+
+    // a start tour built the chosen way; rng picks the shuffle or the
+    // nearest-neighbour start city, the other constructions ignore it
+    template <typename P, typename Rng>
+    std::vector<int> initialTour(const std::vector<P> &points, const CandidateLists &cand, Construction how, Rng &rng)
+    {
+        int n = points.size();
+        switch (how)
+        {
+        case NEAREST_NEIGHBOUR:
+            return nearestNeighbourTour(points, n == 0 ? 0 : std::uniform_int_distribution<int>(0, n - 1)(rng));
+        case GREEDY_EDGE:
+            return greedyEdgeTour(points, cand);
+        case SPACE_FILLING_CURVE:
+            return spaceFillingCurveTour(points);
+        case CHRISTOFIDES:
+            return christofidesTour(points, cand);
+        default:
+        {
+            std::vector<int> tour(n);
+            std::iota(tour.begin(), tour.end(), 0);
+            std::shuffle(tour.begin(), tour.end(), rng);
+            return tour;
+        }
+        }
+    }
+}
@@ -0,0 +1,512 @@
+/*
+Candidate-list driven 2-opt / Or-opt local search for the TSP
+
+Instead of trying every pair of positions, each city only looks at its k
+nearest neighbours (CandidateLists, built once with a uniform grid):
+
+  2-opt   for city a and its tour neighbour b, try every candidate c that
+          is closer to a than b is, adding the edge (a, c) and repairing
+          the tour on the other side; with sorted lists the scan stops at
+          the first c that is no closer
+  Or-opt  move a segment of 1 to 3 cities starting at a next to one of
+          the candidates of its end cities, in either orientation
+
+  LK      (LIN_KERNIGHAN) a variable-depth chain of 2-opt moves: remove
+          (t1, t2), add (t2, t3) for a candidate t3, remove (t3, t4) and
+          close with (t4, t1); then keep going with t4 as the new t2 while
+          the open gain stays positive. The chain is cut back to its best
+          closed tour, or undone if none improved. The first step tries
+          the LK_BREADTH most promising t3, deeper steps only the best;
+          edges added by the chain are never removed again.
+
+Don't-look bits: a city whose neighbourhood gave no improvement is
+skipped until one of its tour edges changes. The active cities are kept
+in a FIFO queue, so a local optimum is reached when the queue is empty.
+
+The tour is held in a tour.h representation, ArrayTour by default or
+TwoLevelTour for large instances, where LK's many flips would otherwise
+dominate. Every change is a sequence of 2-opt flips.
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <queue>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "tsp_moves.h"
+#include "tour.h"
+
+namespace tsp
+{
+    // calls visit(c) for the cells c = y * side + x of the square ring at
+    // Chebyshev distance r around (cx, cy), skipping those off the grid
+    template <typename Visit>
+    void forEachRingCell(int cx, int cy, int r, int side, Visit visit)
+    {
+        for (int y = cy - r; y <= cy + r; ++y)
+        {
+            if (y < 0 || y >= side)
+                continue;
+            // whole rows at the top and bottom, two cells otherwise
+            int step = (y == cy - r || y == cy + r) ? 1 : std::max(1, 2 * r);
+            for (int x = cx - r; x <= cx + r; x += step)
+            {
+                if (x >= 0 && x < side)
+                    visit(y * side + x);
+            }
+        }
+    }
+
+    // the k nearest neighbours of every city, closest first
+    class CandidateLists
+    {
+    public:
+        CandidateLists() = default;
+
+        // points need .X and .Y, like Point in the TSP solvers
+        template <typename P>
+        CandidateLists(const std::vector<P> &points, int k)
+        {
+            n = points.size();
+            width = std::max(0, std::min(k, n - 1));
+            lists.assign((size_t)n * width, -1);
+            if (width == 0)
+                return;
+
+            // about two cities per cell
+            double minX = points[0].X, maxX = minX, minY = points[0].Y, maxY = minY;
+            for (const P &p : points)
+            {
+                minX = std::min(minX, p.X);
+                maxX = std::max(maxX, p.X);
+                minY = std::min(minY, p.Y);
+                maxY = std::max(maxY, p.Y);
+            }
+            int side = std::max(1, (int)std::sqrt(n / 2.0));
+            double cellW = std::max((maxX - minX) / side, 1e-12);
+            double cellH = std::max((maxY - minY) / side, 1e-12);
+            auto cellOf = [&](const P &p, int &cx, int &cy)
+            {
+                cx = std::min(side - 1, (int)((p.X - minX) / cellW));
+                cy = std::min(side - 1, (int)((p.Y - minY) / cellH));
+            };
+
+            // counting sort of the cities by cell
+            std::vector<int> start(side * side + 1, 0), items(n);
+            for (const P &p : points)
+            {
+                int cx, cy;
+                cellOf(p, cx, cy);
+                start[cy * side + cx + 1]++;
+            }
+            for (int c = 0; c < side * side; ++c)
+                start[c + 1] += start[c];
+            std::vector<int> fill(start.begin(), start.end() - 1);
+            for (int i = 0; i < n; ++i)
+            {
+                int cx, cy;
+                cellOf(points[i], cx, cy);
+                items[fill[cy * side + cx]++] = i;
+            }
+
+            // grow a ring of cells around the city until nothing outside
+            // it can beat the k-th best found so far
+            double cellMin = std::min(cellW, cellH);
+            std::priority_queue<std::pair<double, int>> best; // max-heap on distance
+            for (int i = 0; i < n; ++i)
+            {
+                int cx, cy;
+                cellOf(points[i], cx, cy);
+                for (int r = 0; r < side; ++r)
+                {
+                    forEachRingCell(cx, cy, r, side, [&](int c)
+                                    {
+                                        for (int s = start[c]; s < start[c + 1]; ++s)
+                                        {
+                                            int j = items[s];
+                                            if (j == i)
+                                                continue;
+                                            double dx = points[i].X - points[j].X, dy = points[i].Y - points[j].Y;
+                                            double dist = dx * dx + dy * dy;
+                                            if ((int)best.size() < width)
+                                                best.push({dist, j});
+                                            else if (dist < best.top().first)
+                                            {
+                                                best.pop();
+                                                best.push({dist, j});
+                                            }
+                                        }
+                                    });
+                    double reach = r * cellMin;
+                    if ((int)best.size() == width && best.top().first <= reach * reach)
+                        break;
+                }
+
+                for (int slot = width - 1; slot >= 0; --slot)
+                {
+                    lists[(size_t)i * width + slot] = best.top().second;
+                    best.pop();
+                }
+            }
+        }
+
+        // from any symmetric distance callable, O(n^2 log k): for instances
+        // given as a matrix rather than coordinates
+        template <typename Dist>
+        CandidateLists(int n, Dist d, int k) : n(n)
+        {
+            width = std::max(0, std::min(k, n - 1));
+            lists.assign((size_t)n * width, -1);
+
+            std::vector<int> others(n);
+            for (int i = 0; i < n; ++i)
+            {
+                std::iota(others.begin(), others.end(), 0);
+                std::swap(others[i], others[n - 1]);
+                std::partial_sort(others.begin(), others.begin() + width, others.end() - 1, [&](int a, int b)
+                                  { return d(i, a) < d(i, b); });
+                std::copy(others.begin(), others.begin() + width, lists.begin() + (size_t)i * width);
+            }
+        }
+
+        const int *begin(int city) const
+        {
+            return lists.data() + (size_t)city * width;
+        }
+
+        const int *end(int city) const
+        {
+            return begin(city) + width;
+        }
+
+        int k() const
+        {
+            return width;
+        }
+
+    private:
+        int n = 0;
+        int width = 0;
+        std::vector<int> lists;
+    };
+
+    template <typename Dist, typename Tour = ArrayTour>
+    class LocalSearch
+    {
+    public:
+        LocalSearch(const CandidateLists &cand, Dist d, Neighbourhood moves = OR_2OPT)
+            : cand(cand), d(d), moves(moves)
+        {
+        }
+
+        // improves tour in place up to a local optimum of the neighbourhood
+        // and returns the change in length (<= 0)
+        double optimise(std::vector<int> &path)
+        {
+            n = path.size();
+            flips = 0;
+            if (n < 5)
+                return 0.0;
+
+            tour = Tour(path);
+
+            dontLook.assign(n, 0);
+            active.clear();
+            for (int city : path)
+                active.push_back(city);
+
+            double total = 0.0;
+            while (!active.empty())
+            {
+                int a = active.front();
+                active.pop_front();
+                dontLook[a] = 1;
+
+                double gain;
+                while ((gain = improveCity(a)) < 0)
+                    total += gain; // keep working on a while it improves
+            }
+            path = tour.order();
+            return total;
+        }
+
+        // 2-opt moves made, counting LK steps that were undone
+        long long movesApplied() const
+        {
+            return flips;
+        }
+
+    private:
+        // improvements below this are rounding noise
+        static constexpr double EPS = 1e-10;
+        static constexpr int LK_DEPTH = 12;
+        static constexpr int LK_BREADTH = 5;
+
+        const CandidateLists &cand;
+        Dist d;
+        Neighbourhood moves;
+
+        Tour tour;
+        int n = 0;
+        std::vector<char> dontLook;
+        std::deque<int> active;
+        long long flips = 0;
+
+        // one LK step, as the arguments of its move2
+        struct Flip
+        {
+            int a, b, c, e;
+        };
+        std::vector<Flip> chain;
+        std::vector<std::pair<int, int>> added;
+
+        int next(int city) const
+        {
+            return tour.next(city);
+        }
+
+        int prev(int city) const
+        {
+            return tour.prev(city);
+        }
+
+        void wake(int city)
+        {
+            if (dontLook[city])
+            {
+                dontLook[city] = 0;
+                active.push_back(city);
+            }
+        }
+
+        void move2(int a, int b, int c, int e)
+        {
+            tsp::move2(tour, a, b, c, e);
+            flips++;
+        }
+
+        double improveCity(int a)
+        {
+            double gain = 0.0;
+            if (moves == LIN_KERNIGHAN)
+                gain = tryLK(a);
+            else if (moves != OR_OPT)
+                gain = try2Opt(a);
+            if (gain < 0 || moves == TWO_OPT)
+                return gain;
+            return tryOrOpt(a);
+        }
+
+        bool isAdded(int u, int v) const
+        {
+            for (const std::pair<int, int> &edge : added)
+                if ((edge.first == u && edge.second == v) || (edge.first == v && edge.second == u))
+                    return true;
+            return false;
+        }
+
+        // t4 is the tour neighbour of t3 that makes removing (t1, t2) and
+        // (t3, t4) and adding (t2, t3) and (t4, t1) a valid 2-opt move
+        int partner(int t1, int t2, int t3) const
+        {
+            return next(t1) == t2 ? prev(t3) : next(t3);
+        }
+
+        double tryLK(int t1)
+        {
+            for (int dir = 0; dir < 2; ++dir)
+            {
+                int t2 = dir == 0 ? next(t1) : prev(t1);
+                double g = d(t1, t2);
+
+                // first step: the most promising t3 by d(t3, t4) - d(t2, t3)
+                std::pair<double, int> first[LK_BREADTH];
+                int count = 0;
+                for (const int *it = cand.begin(t2); it != cand.end(t2); ++it)
+                {
+                    int t3 = *it;
+                    if (d(t2, t3) >= g)
+                        break;
+                    int t4 = partner(t1, t2, t3);
+                    if (t3 == t1 || t4 == t2 || t4 == t1)
+                        continue;
+                    double open = d(t3, t4) - d(t2, t3);
+                    if (count == LK_BREADTH && open <= first[count - 1].first)
+                        continue;
+                    int slot = count < LK_BREADTH ? count++ : count - 1;
+                    for (; slot > 0 && first[slot - 1].first < open; --slot)
+                        first[slot] = first[slot - 1];
+                    first[slot] = {open, t3};
+                }
+
+                for (int option = 0; option < count; ++option)
+                {
+                    double delta = lkChain(t1, t2, first[option].second, g);
+                    if (delta < 0)
+                        return delta;
+                }
+            }
+            return 0.0;
+        }
+
+        // runs a chain from the first step t1, t2, t3 (open gain g before
+        // it) and keeps its best prefix; returns the change in length
+        double lkChain(int t1, int t2, int t3, double g)
+        {
+            chain.clear();
+            added.clear();
+            double length = 0.0, bestLength = 0.0;
+            size_t bestSize = 0;
+
+            for (int depth = 0; depth < LK_DEPTH; ++depth)
+            {
+                int t4 = partner(t1, t2, t3);
+                double dt2t3 = d(t2, t3), dt3t4 = d(t3, t4);
+                length += dt2t3 + d(t4, t1) - d(t1, t2) - dt3t4;
+                g += dt3t4 - dt2t3;
+
+                // (t2, t3) and (t1, t4) become tour edges
+                chain.push_back(Flip{t2, t1, t3, t4});
+                move2(t2, t1, t3, t4);
+                added.push_back({t2, t3});
+                if (length < bestLength - EPS)
+                {
+                    bestLength = length;
+                    bestSize = chain.size();
+                }
+
+                // next step: (t1, t4) is the edge to remove
+                t2 = t4;
+                int bestT3 = -1;
+                double bestOpen = -std::numeric_limits<double>::infinity();
+                for (const int *it = cand.begin(t2); it != cand.end(t2); ++it)
+                {
+                    int c = *it;
+                    double dt2c = d(t2, c);
+                    if (dt2c >= g)
+                        break;
+                    int e = partner(t1, t2, c);
+                    if (c == t1 || e == t2 || e == t1 || isAdded(c, e))
+                        continue;
+                    double open = d(c, e) - dt2c;
+                    if (open > bestOpen)
+                    {
+                        bestOpen = open;
+                        bestT3 = c;
+                    }
+                }
+                if (bestT3 < 0)
+                    break;
+                t3 = bestT3;
+            }
+
+            // undo the steps after the best closed tour
+            while (chain.size() > bestSize)
+            {
+                const Flip &f = chain.back();
+                move2(f.a, f.c, f.b, f.e);
+                chain.pop_back();
+            }
+            for (const Flip &f : chain)
+            {
+                wake(f.a);
+                wake(f.b);
+                wake(f.c);
+                wake(f.e);
+            }
+            return bestLength;
+        }
+
+        double try2Opt(int a)
+        {
+            for (int dir = 0; dir < 2; ++dir)
+            {
+                int b = dir == 0 ? next(a) : prev(a);
+                double dab = d(a, b);
+                for (const int *it = cand.begin(a); it != cand.end(a); ++it)
+                {
+                    int c = *it;
+                    double dac = d(a, c);
+                    if (dac >= dab)
+                        break; // sorted: no later candidate gains either
+                    int e = dir == 0 ? next(c) : prev(c);
+                    if (c == b || e == a)
+                        continue;
+
+                    double delta = dac + d(b, e) - dab - d(c, e);
+                    if (delta < -EPS)
+                    {
+                        move2(a, b, c, e);
+                        wake(a);
+                        wake(b);
+                        wake(c);
+                        wake(e);
+                        return delta;
+                    }
+                }
+            }
+            return 0.0;
+        }
+
+        // moves the segment a .. s2 (1 to 3 cities, forward from a) between
+        // two adjacent cities x -> y elsewhere in the tour
+        double tryOrOpt(int a)
+        {
+            int s2 = a;
+            for (int len = 1; len <= 3 && len <= n - 4; ++len, s2 = next(s2))
+            {
+                int s1 = a;
+                int p = prev(s1), nx = next(s2);
+                double removeGain = d(p, s1) + d(s2, nx) - d(p, nx);
+                if (removeGain <= EPS)
+                    continue;
+
+                for (int end = 0; end < 2; ++end)
+                {
+                    int from = end == 0 ? s1 : s2;
+                    for (const int *it = cand.begin(from); it != cand.end(from); ++it)
+                    {
+                        int c = *it;
+                        if (d(from, c) >= removeGain)
+                            break;
+                        if (tour.between(s1, c, s2))
+                            continue;
+
+                        // both tour edges at c
+                        for (int side = 0; side < 2; ++side)
+                        {
+                            int x = side == 0 ? c : prev(c);
+                            int y = next(x);
+                            if (tour.between(s1, x, s2) || tour.between(s1, y, s2) || x == p)
+                                continue;
+
+                            double dxy = d(x, y);
+                            double keep = d(x, s1) + d(s2, y) - dxy;    // x s1 .. s2 y
+                            double flipped = d(x, s2) + d(s1, y) - dxy; // x s2 .. s1 y
+                            double delta = std::min(keep, flipped) - removeGain;
+                            if (delta < -EPS)
+                            {
+                                moveSegment(tour, p, s1, s2, nx, x, y, flipped <= keep);
+                                flips += flipped <= keep || s1 == s2 ? 2 : 3;
+                                wake(p);
+                                wake(nx);
+                                wake(s1);
+                                wake(s2);
+                                wake(x);
+                                wake(y);
+                                return delta;
+                            }
+                        }
+                    }
+                }
+            }
+            return 0.0;
+        }
+    };
+}
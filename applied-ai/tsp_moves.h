@@ -0,0 +1,170 @@
+/*
+Move evaluation for the TSP solvers
+
+A tour is a vector<int> of city ids, closed from the last city back to
+the first. d(u, v) is any symmetric distance callable.
+
+2-opt: reversing tour[i..j] removes the edges (a, b) and (c, e) around
+the segment and adds (a, c) and (b, e):
+
+    ... a [b ... c] e ...   ->   ... a [c ... b] e ...
+
+so its cost change only needs those four distances, instead of the
+whole tour length before and after. The solvers evaluate the delta,
+decide, and reverse the segment in place only if the move is accepted,
+tracking the current length incrementally.
+
+Or-opt: a segment of 1 to 3 cities is cut out and put back between two
+adjacent cities x and y elsewhere, possibly reversed:
+
+    ... p [s1 .. s2] nx ... x y ...   ->   ... p nx ... x [s1 .. s2] y ...
+
+six distances again. The random moves are given by cities and applied
+with flips, so SA and the hill climbers run on any tour representation
+of tour.h. OR_2OPT draws either move with equal probability.
+LIN_KERNIGHAN chains 2-opt moves to a variable depth and needs the
+candidate lists of tsp_local_search.h; drawn at random it is OR_2OPT,
+its building blocks.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <random>
+#include <algorithm>
+#include <utility>
+
+#include "tour.h"
+
+namespace tsp
+{
+    template <typename Dist>
+    auto tourLength(const std::vector<int> &tour, Dist d) -> decltype(d(0, 0))
+    {
+        decltype(d(0, 0)) total = 0;
+        int n = tour.size();
+        for (int i = 0; i < n; ++i)
+            total += d(tour[i], tour[(i + 1) % n]);
+        return total;
+    }
+
+    // cost change of reversing tour[i..j], 0 <= i < j < n
+    template <typename Dist>
+    auto twoOptDelta(const std::vector<int> &tour, int i, int j, Dist d) -> decltype(d(0, 0))
+    {
+        int n = tour.size();
+        if (i == 0 && j == n - 1)
+            return 0; // the whole tour backwards is the same cycle
+
+        int a = tour[(i + n - 1) % n], b = tour[i];
+        int c = tour[j], e = tour[(j + 1) % n];
+        return d(a, c) + d(b, e) - d(a, b) - d(c, e);
+    }
+
+    inline void applyTwoOpt(std::vector<int> &tour, int i, int j)
+    {
+        std::reverse(tour.begin() + i, tour.begin() + j + 1);
+    }
+
+    enum Neighbourhood
+    {
+        TWO_OPT,
+        OR_OPT,
+        OR_2OPT,
+        LIN_KERNIGHAN
+    };
+
+    // "2opt", "oropt", "or2opt" or "lk"; false for anything else
+    inline bool parseNeighbourhood(std::string_view name, Neighbourhood &out)
+    {
+        const std::pair<std::string_view, Neighbourhood> names[] = {
+            {"2opt", TWO_OPT}, {"oropt", OR_OPT}, {"or2opt", OR_2OPT}, {"lk", LIN_KERNIGHAN}};
+        for (const auto &[key, value] : names)
+        {
+            if (name == key)
+            {
+                out = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // a move in terms of cities, so it works on any tour.h representation:
+    //   2-opt   removes (a, next(a)) and (c, next(c))
+    //   Or-opt  moves the len cities from a forward to between c and next(c)
+    struct Move
+    {
+        bool orOpt;
+        int a, c;
+        int len;
+        bool reversed;
+    };
+
+    // uniform random move of the neighbourhood for a tour of n >= 3 cities
+    // (Or-opt needs n >= 5 and falls back to 2-opt below that)
+    template <typename Tour, typename Rng>
+    Move randomMove(const Tour &tour, Neighbourhood moves, Rng &rng)
+    {
+        int n = tour.size();
+        std::uniform_int_distribution<int> city(0, n - 1);
+        bool orOpt = moves == OR_OPT || ((moves == OR_2OPT || moves == LIN_KERNIGHAN) && (rng() & 1));
+        if (orOpt && n >= 5)
+        {
+            int len = std::uniform_int_distribution<int>(1, 3)(rng);
+            int s1 = city(rng), s2 = s1;
+            for (int k = 1; k < len; ++k)
+                s2 = tour.next(s2);
+            // c is neither in the segment nor just before it
+            int c;
+            do
+            {
+                c = city(rng);
+            } while (tour.between(tour.prev(s1), c, s2));
+            return Move{true, s1, c, len, (rng() & 1) != 0};
+        }
+
+        int a = city(rng), c;
+        do
+        {
+            c = city(rng);
+        } while (a == c);
+        return Move{false, a, c, 0, false};
+    }
+
+    template <typename Tour, typename Dist>
+    auto moveDelta(const Tour &tour, const Move &m, Dist d) -> decltype(d(0, 0))
+    {
+        if (!m.orOpt)
+        {
+            int b = tour.next(m.a), e = tour.next(m.c);
+            return d(m.a, m.c) + d(b, e) - d(m.a, b) - d(m.c, e);
+        }
+
+        int s1 = m.a, s2 = m.a;
+        for (int k = 1; k < m.len; ++k)
+            s2 = tour.next(s2);
+        int p = tour.prev(s1), nx = tour.next(s2);
+        int x = m.c, y = tour.next(x);
+
+        auto removed = d(p, s1) + d(s2, nx) + d(x, y);
+        auto added = d(p, nx) + (m.reversed ? d(x, s2) + d(s1, y) : d(x, s1) + d(s2, y));
+        return added - removed;
+    }
+
+    template <typename Tour>
+    void applyMove(Tour &tour, const Move &m)
+    {
+        if (!m.orOpt)
+        {
+            tour.flip(m.a, tour.next(m.a), m.c, tour.next(m.c));
+            return;
+        }
+
+        int s1 = m.a, s2 = m.a;
+        for (int k = 1; k < m.len; ++k)
+            s2 = tour.next(s2);
+        moveSegment(tour, tour.prev(s1), s1, s2, tour.next(s2), m.c, tour.next(m.c), m.reversed);
+    }
+}
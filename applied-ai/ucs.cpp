@@ -1,5 +1,9 @@
 /*
 Simple example of Uniform Cost Search using Dijkstra's Algorithm
+
+The search is templated on the weight type W (see weights.h): UCS<> uses
+int, UCS<int64_t> avoids overflow on long routes, UCS<double> and
+UCS<Fixed<100>> take fractional distances.
 */
 
 #include <vector>
@@ -8,39 +12,59 @@ Simple example of Uniform Cost Search using Dijkstra's Algorithm
 #include <iostream>
 #include <limits.h>
 
+#include "compressed_graph.h"
+#include "weights.h"
+#include "components.h"
+#include "route_cache.h"
+
 using namespace std;
 
+template <typename W = int>
 struct Node
 {
     int id;
     Node *next;
-    int cost;
+    W cost;
 };
 
+template <typename W = int>
 class UCS
 {
+private:
+    typedef WeightTraits<W> Traits;
+    typedef pair<W, int> Entry; // (cost, neigh_idx)
+
 public:
-    Node *findPath(vector<vector<pair<int, int>>> &adj, int S, int T)
+    // edges are (cost, neigh_idx). Graph is vector<vector<pair<W, int>>>
+    // or anything shaped like it, such as CompressedWeightedGraph built
+    // with weightFirst = true. If a ComponentIndex (built with
+    // ComponentIndex::SecondTarget) is given, targets in another
+    // component are rejected before searching
+    template <typename Graph>
+    Node<W> *findPath(const Graph &adj, int S, int T, const ComponentIndex *components = nullptr)
     {
         if (S == T)
         {
-            Node *head = new Node{S, nullptr, 0};
+            Node<W> *head = new Node<W>{S, nullptr, Traits::zero()};
             return head;
         }
 
+        if (components != nullptr && !components->mayReach(S, T))
+            return nullptr; // different components, nothing to explore
+
         int n = adj.size();
         vector<bool> visited(n, 0);
         vector<int> parents(n, -1);
 
-        vector<int> dist(n, INT_MAX);
-        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq; // by default it's ordered by first
+        vector<W> dist(n, Traits::infinity());
+        priority_queue<Entry, vector<Entry>, greater<Entry>> pq; // by default it's ordered by first
 
-        pq.push(make_pair(0, S));
-        dist[S] = 0;
+        pq.push(make_pair(Traits::zero(), S));
+        dist[S] = Traits::zero();
 
         while (!pq.empty())
         {
-            pair<int, int> curr = pq.top();
+            Entry curr = pq.top();
             pq.pop();
             if (visited[curr.second])
                 continue; // we skip those rubbish nodes with higher costs
@@ -53,16 +77,16 @@ public:
                 break;
             }
 
-            for (size_t i = 0; i < adj[curr.second].size(); ++i)
+            for (Entry neigh : adj[curr.second])
             {
-                pair<int, int> neigh = adj[curr.second][i];
                 if (!visited[neigh.second])
                 {
-                    if (dist[neigh.second] > dist[curr.second] + neigh.first)
+                    W newDist = Traits::add(dist[curr.second], neigh.first);
+                    if (dist[neigh.second] > newDist)
                     {
                         // update with the lower cost path
                         parents[neigh.second] = curr.second;
-                        dist[neigh.second] = dist[curr.second] + neigh.first;
+                        dist[neigh.second] = newDist;
                         neigh.first = dist[neigh.second];
                         pq.push(neigh);
                     }
@@ -74,17 +98,128 @@ public:
             return nullptr;
 
         int curr = T;
-        Node *head = new Node{curr, nullptr};
+        Node<W> *head = new Node<W>{curr, nullptr, dist[curr]};
         while (curr != S)
         {
             curr = parents[curr];
-            Node *parentNode = new Node{curr, head, dist[curr]};
+            Node<W> *parentNode = new Node<W>{curr, head, dist[curr]};
             head = parentNode;
         }
         return head;
     }
 
-    void printPath(Node *head)
+    // one source, many targets: a single Dijkstra that stops as soon as
+    // every target is settled. paths[i] is the path to targets[i] (nullptr
+    // if unreachable), all built from the same parents array; delete each
+    // one with deletePath
+    template <typename Graph>
+    vector<Node<W> *> findPaths(const Graph &adj, int S, const vector<int> &targets,
+                                const ComponentIndex *components = nullptr)
+    {
+        int n = adj.size();
+        vector<Node<W> *> paths(targets.size(), nullptr);
+
+        // remaining counts distinct targets that may still be reached
+        vector<bool> isTarget(n, 0);
+        int remaining = 0;
+        for (int T : targets)
+        {
+            if (isTarget[T])
+                continue;
+            if (components != nullptr && !components->mayReach(S, T))
+                continue; // different components, never settled
+            isTarget[T] = true;
+            remaining++;
+        }
+
+        vector<bool> visited(n, 0);
+        vector<int> parents(n, -1);
+        vector<W> dist(n, Traits::infinity());
+        priority_queue<Entry, vector<Entry>, greater<Entry>> pq;
+
+        pq.push(make_pair(Traits::zero(), S));
+        dist[S] = Traits::zero();
+
+        while (!pq.empty() && remaining > 0)
+        {
+            Entry curr = pq.top();
+            pq.pop();
+            if (visited[curr.second])
+                continue;
+
+            visited[curr.second] = true;
+            if (isTarget[curr.second])
+                remaining--; // its dist and parent are final now
+
+            for (Entry neigh : adj[curr.second])
+            {
+                W newDist = Traits::add(dist[curr.second], neigh.first);
+                if (!visited[neigh.second] && dist[neigh.second] > newDist)
+                {
+                    parents[neigh.second] = curr.second;
+                    dist[neigh.second] = newDist;
+                    neigh.first = dist[neigh.second];
+                    pq.push(neigh);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            int curr = targets[i];
+            if (!visited[curr])
+                continue;
+
+            Node<W> *head = new Node<W>{curr, nullptr, dist[curr]};
+            while (curr != S)
+            {
+                curr = parents[curr];
+                head = new Node<W>{curr, head, dist[curr]};
+            }
+            paths[i] = head;
+        }
+        return paths;
+    }
+
+    // one-to-all Dijkstra from S: dist[v] is infinity and parents[v] is -1
+    // for unreachable v. Walking parents from any T gives its path, which
+    // is what RouteCache keeps for hot sources
+    template <typename Graph>
+    void shortestPathTree(const Graph &adj, int S, vector<int> &parents, vector<W> &dist)
+    {
+        int n = adj.size();
+        vector<bool> visited(n, 0);
+        parents.assign(n, -1);
+        dist.assign(n, Traits::infinity());
+
+        priority_queue<Entry, vector<Entry>, greater<Entry>> pq;
+        pq.push(make_pair(Traits::zero(), S));
+        dist[S] = Traits::zero();
+
+        while (!pq.empty())
+        {
+            Entry curr = pq.top();
+            pq.pop();
+            if (visited[curr.second])
+                continue;
+
+            visited[curr.second] = true;
+
+            for (Entry neigh : adj[curr.second])
+            {
+                W newDist = Traits::add(dist[curr.second], neigh.first);
+                if (!visited[neigh.second] && dist[neigh.second] > newDist)
+                {
+                    parents[neigh.second] = curr.second;
+                    dist[neigh.second] = newDist;
+                    neigh.first = dist[neigh.second];
+                    pq.push(neigh);
+                }
+            }
+        }
+    }
+
+    void printPath(Node<W> *head)
     {
         if (head == nullptr)
             return;
@@ -97,18 +232,130 @@ public:
         cout << head->id << ", " << head->cost << endl;
     }
 
-    void deletePath(Node *head)
+    void deletePath(Node<W> *head)
     {
         if (head == nullptr)
             return;
 
-        Node *curr = head;
+        Node<W> *curr = head;
         while (curr->next != nullptr)
         {
-            Node *nextNode = curr->next;
+            Node<W> *nextNode = curr->next;
             delete curr;
             curr = nextNode;
         }
         delete curr;
     }
-};
\ No newline at end of file
+};
+
+// the path of a Node list as a RouteCache entry
+template <typename W>
+typename RouteCache<W>::Route toRoute(Node<W> *head)
+{
+    typename RouteCache<W>::Route route;
+    for (Node<W> *curr = head; curr != nullptr; curr = curr->next)
+    {
+        route.path.push_back(curr->id);
+        route.cost = curr->cost;
+        route.found = true;
+    }
+    return route;
+}
+
+int main()
+{
+    // a 20 x 20 grid of roads with pseudo-random lengths 1 .. 9
+    int side = 20, n = side * side;
+    vector<vector<pair<int, int>>> adj(n);
+    auto road = [&](int u, int v)
+    {
+        int w = 1 + (u * 7 + v * 13) % 9;
+        adj[u].push_back({w, v});
+        adj[v].push_back({w, u});
+    };
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            if (x + 1 < side)
+                road(y * side + x, y * side + x + 1);
+            if (y + 1 < side)
+                road(y * side + x, (y + 1) * side + x);
+        }
+    }
+
+    UCS<> solver;
+    RouteCache<int> cache(1 << 20);
+
+    auto search = [&](int S, int T)
+    {
+        Node<> *path = solver.findPath(adj, S, T);
+        RouteCache<int>::Route route = toRoute(path);
+        solver.deletePath(path);
+        return route;
+    };
+    auto buildTree = [&](int S, vector<int> &parents, vector<int> &dist)
+    {
+        solver.shortestPathTree(adj, S, parents, dist);
+    };
+
+    // origins with several targets become hot and get a whole tree, the
+    // lone (123, 7) pair stays a cached route. Every cached answer is
+    // checked against a fresh search
+    vector<pair<int, int>> asked = {{123, 7}};
+    for (int S : {0, 37, 210})
+        for (int T : {399, 5, 150, 37})
+            asked.push_back({S, T});
+
+    int queries = 0, mismatches = 0;
+    for (int round = 0; round < 5; ++round)
+    {
+        for (auto [S, T] : asked)
+        {
+            RouteCache<int>::Route cached = cache.findPath(S, T, search, buildTree);
+            RouteCache<int>::Route fresh = search(S, T);
+            queries++;
+            if (cached.found != fresh.found || cached.cost != fresh.cost ||
+                cached.path.front() != S || cached.path.back() != T)
+                mismatches++;
+        }
+    }
+
+    RouteCache<int>::Stats stats = cache.lastStats();
+    cout << queries << " queries, " << mismatches << " mismatches: " << stats.routeHits << " route hits, "
+         << stats.treeHits << " tree hits, " << stats.misses << " misses, " << stats.treesBuilt << " trees built"
+         << endl;
+
+    RouteCache<int>::Route route = cache.findPath(0, 399, search, buildTree);
+    cout << "0 -> 399 costs " << route.cost << " over " << route.path.size() - 1 << " roads" << endl;
+
+    // one source, many targets: a repeated target, the source itself and
+    // a city with no roads at all, which stays nullptr
+    adj.emplace_back();
+    int island = n;
+    vector<int> targets = {399, 5, 399, 0, island};
+    vector<Node<> *> paths = solver.findPaths(adj, 0, targets);
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        cout << "0 -> " << targets[i] << ": ";
+        if (paths[i] == nullptr)
+        {
+            cout << "unreachable" << endl;
+            continue;
+        }
+        Node<> *fresh = solver.findPath(adj, 0, targets[i]);
+        Node<> *last = paths[i];
+        while (last->next != nullptr)
+            last = last->next;
+        Node<> *freshLast = fresh;
+        while (freshLast->next != nullptr)
+            freshLast = freshLast->next;
+        cout << "cost " << last->cost << (last->cost == freshLast->cost ? " (matches findPath)" : " (MISMATCH)") << endl;
+        if (last->cost != freshLast->cost)
+            mismatches++;
+        solver.deletePath(fresh);
+        solver.deletePath(paths[i]);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
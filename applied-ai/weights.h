@@ -0,0 +1,137 @@
+/*
+Weight types for the search classes
+
+UCS and AStar are templated on the edge weight W and only touch it
+through WeightTraits<W>:
+
+  infinity()   the "not reached yet" sentinel (INT_MAX for int)
+  add(a, b)    a + b that saturates at infinity() instead of overflowing
+
+Provided specialisations:
+
+  int32_t      densest, good while the longest path stays below 2^31
+  int64_t      for long routes
+  float/double fractional weights, infinity() is the IEEE infinity
+  Fixed<S>     fractional weights stored as an int64 count of 1/S units,
+               e.g. Fixed<100> keeps miles to two decimals exactly;
+               explicitly constructible from int and double, so integer
+               or floating point heuristics work with AStar<Fixed<S>>
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <ostream>
+#include <cmath>
+
+template <typename W, typename Enable = void>
+struct WeightTraits;
+
+// integer weights: saturate at the maximum value
+template <typename W>
+struct WeightTraits<W, typename std::enable_if<std::is_integral<W>::value>::type>
+{
+    static constexpr W infinity()
+    {
+        return std::numeric_limits<W>::max();
+    }
+
+    static constexpr W zero()
+    {
+        return 0;
+    }
+
+    static W add(W a, W b)
+    {
+        W sum;
+        if (a == infinity() || b == infinity() || __builtin_add_overflow(a, b, &sum) || sum == infinity())
+            return infinity();
+        return sum;
+    }
+};
+
+// floating point weights: IEEE infinity already saturates
+template <typename W>
+struct WeightTraits<W, typename std::enable_if<std::is_floating_point<W>::value>::type>
+{
+    static constexpr W infinity()
+    {
+        return std::numeric_limits<W>::infinity();
+    }
+
+    static constexpr W zero()
+    {
+        return 0;
+    }
+
+    static W add(W a, W b)
+    {
+        return a + b;
+    }
+};
+
+// scaled fixed-point value: raw / Scale
+template <int64_t Scale>
+struct Fixed
+{
+    int64_t raw = 0;
+
+    Fixed() = default;
+
+    // whole units, e.g. an integer heuristic: Fixed<100>(3) is 3.00
+    explicit Fixed(int value) : raw((int64_t)value * Scale) {}
+
+    // rounded to the nearest 1/Scale
+    explicit Fixed(double value) : raw((int64_t)std::llround(value * Scale)) {}
+
+    static Fixed fromRaw(int64_t raw)
+    {
+        Fixed value;
+        value.raw = raw;
+        return value;
+    }
+
+    static Fixed fromDouble(double value)
+    {
+        return Fixed(value);
+    }
+
+    double toDouble() const
+    {
+        return (double)raw / Scale;
+    }
+
+    bool operator<(const Fixed &o) const { return raw < o.raw; }
+    bool operator>(const Fixed &o) const { return raw > o.raw; }
+    bool operator<=(const Fixed &o) const { return raw <= o.raw; }
+    bool operator>=(const Fixed &o) const { return raw >= o.raw; }
+    bool operator==(const Fixed &o) const { return raw == o.raw; }
+    bool operator!=(const Fixed &o) const { return raw != o.raw; }
+};
+
+template <int64_t Scale>
+std::ostream &operator<<(std::ostream &out, const Fixed<Scale> &value)
+{
+    return out << value.toDouble();
+}
+
+template <int64_t Scale>
+struct WeightTraits<Fixed<Scale>>
+{
+    static Fixed<Scale> infinity()
+    {
+        return Fixed<Scale>::fromRaw(std::numeric_limits<int64_t>::max());
+    }
+
+    static Fixed<Scale> zero()
+    {
+        return Fixed<Scale>();
+    }
+
+    static Fixed<Scale> add(Fixed<Scale> a, Fixed<Scale> b)
+    {
+        return Fixed<Scale>::fromRaw(WeightTraits<int64_t>::add(a.raw, b.raw));
+    }
+};